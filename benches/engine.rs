@@ -0,0 +1,235 @@
+//    Copyright 2025 Karesis
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+//! Synthetic-tree benchmarks for the engine's hot paths.
+//!
+//! Generates trees with controllable shape (file count, size, depth,
+//! already-licensed fraction, comment style mix) and measures the built
+//! `lice` binary end to end: traversal + probe throughput on licensed
+//! trees, the full rewrite path on unlicensed ones, large-file header
+//! replacement, and files/sec scaling across -j.
+//!
+//! Run with `cargo bench`. Tree size scales with LICE_BENCH_FILES
+//! (default 4000). A benchmark name substring can be passed as the first
+//! argument to run a subset: `cargo bench -- rewrite`.
+
+use std::fs;
+use std::path::{Path, PathBuf};
+use std::process::{Command, Stdio};
+use std::time::Instant;
+
+const LICE: &str = env!("CARGO_BIN_EXE_lice");
+
+/// file extensions cycled through when generating, one per comment style
+const STYLE_EXTS: [&str; 4] = ["c", "py", "rs", "lua"];
+
+const HEADER_TEXT: &str = "Copyright 2025 Example\n\nLicensed for benchmarking only.\n";
+
+/// Shape of a generated tree.
+struct TreeSpec {
+    dirs: usize,
+    depth: usize,
+    files_per_dir: usize,
+    /// body size of each generated file in bytes
+    file_size: usize,
+    /// fraction of files pre-licensed by an initial apply pass, 0.0..=1.0
+    licensed_fraction: f64,
+}
+
+fn main() {
+    // skip flags cargo passes to custom harnesses (e.g. --bench)
+    let filter = std::env::args()
+        .skip(1)
+        .find(|a| !a.starts_with('-'))
+        .unwrap_or_default();
+    let files: usize = std::env::var("LICE_BENCH_FILES")
+        .ok()
+        .and_then(|v| v.parse().ok())
+        .unwrap_or(4000);
+
+    let root = std::env::temp_dir().join(format!("lice-bench-{}", std::process::id()));
+    let _ = fs::remove_dir_all(&root);
+    fs::create_dir_all(&root).expect("create bench root");
+    fs::write(root.join("HEADER.txt"), HEADER_TEXT).expect("write header");
+
+    println!("tree size: {} files (LICE_BENCH_FILES to change)", files);
+
+    let small = TreeSpec {
+        dirs: 64,
+        depth: 4,
+        files_per_dir: files.div_ceil(64),
+        file_size: 512,
+        licensed_fraction: 1.0,
+    };
+    let fresh = TreeSpec {
+        licensed_fraction: 0.0,
+        ..small
+    };
+    let large = TreeSpec {
+        dirs: 4,
+        depth: 1,
+        files_per_dir: 8,
+        file_size: 4 * 1024 * 1024,
+        licensed_fraction: 0.0,
+    };
+
+    let mut runner = Runner {
+        root: &root,
+        filter: &filter,
+    };
+
+    // steady state: every file already carries the header (probe fast path)
+    runner.bench("probe_hit_check", &small, &["--check"]);
+    runner.bench("probe_hit_apply", &small, &[]);
+
+    // cold tree: every file takes the rewrite path
+    runner.bench_fresh("rewrite_miss", &fresh, &[]);
+
+    // multi-MB line-comment files with a stale header to strip and replace
+    runner.bench_fresh("rewrite_large_files", &large, &[]);
+
+    // scaling: files/sec across thread counts on the probe path
+    for jobs in ["1", "2", "4", "8"] {
+        runner.bench(
+            &format!("probe_hit_check_j{}", jobs),
+            &small,
+            &["--check", "-j", jobs],
+        );
+    }
+
+    let _ = fs::remove_dir_all(&root);
+}
+
+struct Runner<'a> {
+    root: &'a Path,
+    filter: &'a str,
+}
+
+impl Runner<'_> {
+    /// Benchmarks repeated runs over one generated tree (read-mostly paths).
+    fn bench(&mut self, name: &str, spec: &TreeSpec, extra_args: &[&str]) {
+        if !name.contains(self.filter) {
+            return;
+        }
+        let tree = self.generate(name, spec);
+        let file_count = spec.dirs * spec.files_per_dir;
+
+        // warm-up, and the pass that pre-licenses `licensed_fraction`
+        run_lice(self.root, &tree, &[]);
+
+        let iters = 5;
+        let start = Instant::now();
+        for _ in 0..iters {
+            run_lice(self.root, &tree, extra_args);
+        }
+        report(name, start.elapsed() / iters, file_count);
+        let _ = fs::remove_dir_all(&tree);
+    }
+
+    /// Benchmarks write paths: the tree is regenerated before every
+    /// iteration so each run really rewrites every file.
+    fn bench_fresh(&mut self, name: &str, spec: &TreeSpec, extra_args: &[&str]) {
+        if !name.contains(self.filter) {
+            return;
+        }
+        let file_count = spec.dirs * spec.files_per_dir;
+        let iters = 3;
+        let mut total = std::time::Duration::ZERO;
+        for _ in 0..iters {
+            let tree = self.generate(name, spec);
+            let start = Instant::now();
+            run_lice(self.root, &tree, extra_args);
+            total += start.elapsed();
+            let _ = fs::remove_dir_all(&tree);
+        }
+        report(name, total / iters, file_count);
+    }
+
+    /// Builds a tree under the bench root following `spec`.
+    fn generate(&self, name: &str, spec: &TreeSpec) -> PathBuf {
+        let tree = self.root.join(name);
+        let body = file_body(spec.file_size);
+        let mut written = 0usize;
+        let total = spec.dirs * spec.files_per_dir;
+
+        for d in 0..spec.dirs {
+            let mut dir = tree.clone();
+            for level in 0..spec.depth {
+                dir = dir.join(format!("d{}_{}", level, d % (level + 2)));
+            }
+            dir = dir.join(format!("leaf{}", d));
+            fs::create_dir_all(&dir).expect("create bench dir");
+
+            for f in 0..spec.files_per_dir {
+                let ext = STYLE_EXTS[(d + f) % STYLE_EXTS.len()];
+                fs::write(dir.join(format!("f{}.{}", f, ext)), &body).expect("write bench file");
+                written += 1;
+            }
+        }
+        assert_eq!(written, total);
+
+        // pre-license the requested fraction with a real apply pass
+        if spec.licensed_fraction > 0.0 {
+            // fraction below 1.0 is approximated by licensing whole subtrees
+            let licensed_dirs = (spec.dirs as f64 * spec.licensed_fraction).round() as usize;
+            for d in 0..licensed_dirs {
+                let mut dir = tree.clone();
+                for level in 0..spec.depth {
+                    dir = dir.join(format!("d{}_{}", level, d % (level + 2)));
+                }
+                run_lice(self.root, &dir.join(format!("leaf{}", d)), &[]);
+            }
+        }
+        tree
+    }
+}
+
+/// One lice invocation; panics if the binary itself fails to run.
+fn run_lice(root: &Path, target: &Path, extra_args: &[&str]) {
+    let status = Command::new(LICE)
+        .arg("-f")
+        .arg(root.join("HEADER.txt"))
+        .arg("--no-cache")
+        .args(extra_args)
+        .arg(target)
+        .stdout(Stdio::null())
+        .stderr(Stdio::null())
+        .status()
+        .expect("spawn lice");
+    // --check exits 1 on missing headers; that is a valid benchmark run
+    assert!(status.code().is_some(), "lice killed by signal");
+}
+
+fn report(name: &str, per_iter: std::time::Duration, files: usize) {
+    let secs = per_iter.as_secs_f64();
+    println!(
+        "{:<24} {:>9.1} ms/iter  {:>10.0} files/sec",
+        name,
+        secs * 1e3,
+        files as f64 / secs
+    );
+}
+
+fn file_body(size: usize) -> Vec<u8> {
+    let mut body = Vec::with_capacity(size);
+    while body.len() < size {
+        body.extend_from_slice(b"let value = compute(); // generated line\n");
+    }
+    body.truncate(size);
+    // keep the final line terminated
+    if body.last() != Some(&b'\n') {
+        body.push(b'\n');
+    }
+    body
+}
@@ -0,0 +1,123 @@
+//    Copyright 2025 Karesis
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+use std::collections::HashMap;
+use std::fs;
+use std::io::{self, Write};
+use std::path::{Path, PathBuf};
+use std::time::UNIX_EPOCH;
+
+/// Default cache file name, created in the working directory.
+pub const CACHE_FILE: &str = ".lice-cache";
+
+/// Identity of a file's content at the time its header was verified.
+/// If mtime and size both match on the next run, the header is still there
+/// and the file does not need to be opened at all.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct FileStamp {
+    pub mtime_secs: u64,
+    pub mtime_nanos: u32,
+    pub size: u64,
+}
+
+impl FileStamp {
+    pub fn from_metadata(meta: &fs::Metadata) -> Option<Self> {
+        let mtime = meta.modified().ok()?;
+        let since_epoch = mtime.duration_since(UNIX_EPOCH).ok()?;
+        Some(Self {
+            mtime_secs: since_epoch.as_secs(),
+            mtime_nanos: since_epoch.subsec_nanos(),
+            size: meta.len(),
+        })
+    }
+}
+
+/// Persistent map of path -> stamp for files whose header was confirmed OK.
+///
+/// Format: a `# lice-cache <token>` first line, then one entry per line,
+/// `<secs> <nanos> <size> <path>`. The token fingerprints the license text,
+/// so editing the header invalidates the whole cache. Only header-ok files
+/// are recorded; anything else must be reprocessed anyway. A full run drops
+/// entries for files it did not see on save, so the cache never grows past
+/// the tree it describes; a partial run (git selection, resume skips) merges
+/// instead, keeping the stamps of everything it deliberately left alone.
+pub struct RunCache {
+    entries: HashMap<PathBuf, FileStamp>,
+}
+
+impl RunCache {
+    /// Loads the cache, tolerating a missing or malformed file (a cold or
+    /// corrupt cache only costs a full pass, never correctness). A token
+    /// mismatch — the license text changed — discards everything.
+    pub fn load(path: &Path, token: u64) -> Self {
+        let mut entries = HashMap::new();
+
+        if let Ok(text) = fs::read_to_string(path) {
+            let mut lines = text.lines();
+            if lines.next() != Some(format!("# lice-cache {}", token).as_str()) {
+                return Self { entries };
+            }
+            for line in lines {
+                let mut parts = line.splitn(4, ' ');
+                let stamp = (|| {
+                    Some(FileStamp {
+                        mtime_secs: parts.next()?.parse().ok()?,
+                        mtime_nanos: parts.next()?.parse().ok()?,
+                        size: parts.next()?.parse().ok()?,
+                    })
+                })();
+                if let (Some(stamp), Some(p)) = (stamp, parts.next()) {
+                    entries.insert(PathBuf::from(p), stamp);
+                }
+            }
+        }
+
+        Self { entries }
+    }
+
+    /// True if `path` was header-ok last run and is unchanged per `stamp`.
+    pub fn is_fresh(&self, path: &Path, stamp: FileStamp) -> bool {
+        self.entries.get(path) == Some(&stamp)
+    }
+
+    /// Writes the entries verified during this run. With `merge` they are
+    /// layered over the loaded entries first -- a run that visited only a
+    /// subset of the tree must not wipe the stamps of the files it skipped.
+    pub fn save<'a, I>(&self, path: &Path, token: u64, entries: I, merge: bool) -> io::Result<()>
+    where
+        I: Iterator<Item = &'a (PathBuf, FileStamp)>,
+    {
+        let mut merged: HashMap<&Path, FileStamp> = HashMap::new();
+        if merge {
+            merged.extend(self.entries.iter().map(|(p, s)| (p.as_path(), *s)));
+        }
+        merged.extend(entries.map(|(p, s)| (p.as_path(), *s)));
+
+        let mut out = io::BufWriter::new(fs::File::create(path)?);
+        writeln!(out, "# lice-cache {}", token)?;
+        for (p, stamp) in &merged {
+            let p = match p.to_str() {
+                // paths with newlines would corrupt the line format
+                Some(s) if !s.contains('\n') => s,
+                _ => continue,
+            };
+            writeln!(
+                out,
+                "{} {} {} {}",
+                stamp.mtime_secs, stamp.mtime_nanos, stamp.size, p
+            )?;
+        }
+        out.flush()
+    }
+}
@@ -0,0 +1,176 @@
+//    Copyright 2025 Karesis
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+//! Extension -> comment-style dispatch.
+//!
+//! Built-in extensions and an optional user mapping file are merged once
+//! at startup into a table sorted by extension; per-file lookups are a
+//! binary search with no allocation, so adding languages is configuration
+//! rather than a fork.
+
+use std::fs;
+use std::path::Path;
+
+#[derive(Debug, Clone, Copy)]
+pub struct LanguageProfile {
+    /// index into the engine's pre-rendered header table
+    pub id: usize,
+
+    /// comment start
+    /// e.g., "/*" or "" (line comment)
+    pub start: &'static str,
+
+    /// comment prefix
+    /// e.g., " * " or "// "
+    pub prefix: &'static str,
+
+    /// comment end
+    /// e.g., " */" or ""
+    pub end: &'static str,
+}
+
+/// number of comment styles (size of the header table)
+pub const STYLE_COUNT: usize = 4;
+
+/// comment styles
+const STYLE_C_LIKE: LanguageProfile = LanguageProfile {
+    id: 0,
+    start: "/*\n",
+    prefix: " * ",
+    end: " */\n\n",
+};
+const STYLE_HASH: LanguageProfile = LanguageProfile {
+    id: 1,
+    start: "",
+    prefix: "# ",
+    end: "\n",
+}; // Python, Shell, Ruby
+const STYLE_DOUBLE_SLASH: LanguageProfile = LanguageProfile {
+    id: 2,
+    start: "",
+    prefix: "// ",
+    end: "\n",
+}; // Rust, Go, Java (line mode)
+const STYLE_DASH: LanguageProfile = LanguageProfile {
+    id: 3,
+    start: "",
+    prefix: "-- ",
+    end: "\n",
+}; // Lua, Haskell, SQL
+
+pub const ALL_STYLES: [LanguageProfile; STYLE_COUNT] =
+    [STYLE_C_LIKE, STYLE_HASH, STYLE_DOUBLE_SLASH, STYLE_DASH];
+
+/// extensions recognized out of the box
+const BUILTIN: &[(&str, LanguageProfile)] = &[
+    ("c", STYLE_C_LIKE),
+    ("h", STYLE_C_LIKE),
+    ("cpp", STYLE_C_LIKE),
+    ("hpp", STYLE_C_LIKE),
+    ("css", STYLE_C_LIKE),
+    ("rs", STYLE_DOUBLE_SLASH),
+    ("go", STYLE_DOUBLE_SLASH),
+    ("java", STYLE_DOUBLE_SLASH),
+    ("js", STYLE_DOUBLE_SLASH),
+    ("ts", STYLE_DOUBLE_SLASH),
+    ("proto", STYLE_DOUBLE_SLASH),
+    ("kt", STYLE_DOUBLE_SLASH),
+    ("swift", STYLE_DOUBLE_SLASH),
+    ("py", STYLE_HASH),
+    ("sh", STYLE_HASH),
+    ("rb", STYLE_HASH),
+    ("yaml", STYLE_HASH),
+    ("toml", STYLE_HASH),
+    ("tf", STYLE_HASH),
+    ("lua", STYLE_DASH),
+    ("hs", STYLE_DASH),
+    ("sql", STYLE_DASH),
+];
+
+/// The merged dispatch table. Entries are sorted by extension, so
+/// `lookup` is one binary search over a contiguous slice -- no per-call
+/// hashing, no allocation, and overrides shadow built-ins naturally.
+pub struct LanguageTable {
+    entries: Vec<(String, LanguageProfile)>,
+}
+
+impl LanguageTable {
+    /// The built-in table alone.
+    pub fn builtin() -> Self {
+        let mut entries: Vec<(String, LanguageProfile)> = BUILTIN
+            .iter()
+            .map(|(ext, style)| (ext.to_string(), *style))
+            .collect();
+        entries.sort_by(|a, b| a.0.cmp(&b.0));
+        Self { entries }
+    }
+
+    /// Merges a user mapping file over the built-ins. One `ext=token`
+    /// pair per line, where the token is the comment leader: `/*`, `//`,
+    /// `#` or `--` (e.g. `cmake=#`). Blank lines and lines starting with
+    /// '#' are comments. Bad lines warn and are ignored; the run goes on
+    /// with whatever parsed.
+    pub fn load_overrides(&mut self, path: &Path) {
+        let text = match fs::read_to_string(path) {
+            Ok(t) => t,
+            Err(e) => {
+                eprintln!("[WARN] Cannot read language map {:?}: {}", path, e);
+                return;
+            }
+        };
+
+        for line in text.lines() {
+            let line = line.trim();
+            if line.is_empty() || line.starts_with('#') {
+                continue;
+            }
+            let Some((ext, token)) = line.split_once('=') else {
+                eprintln!("[WARN] Ignoring language map line (no '='): {}", line);
+                continue;
+            };
+            let ext = ext.trim().trim_start_matches('.');
+            let Some(style) = style_for_token(token.trim()) else {
+                eprintln!(
+                    "[WARN] Ignoring language map line (unknown style {:?}): {}",
+                    token.trim(),
+                    line
+                );
+                continue;
+            };
+            match self.entries.binary_search_by(|(e, _)| e.as_str().cmp(ext)) {
+                Ok(i) => self.entries[i].1 = style,
+                Err(i) => self.entries.insert(i, (ext.to_string(), style)),
+            }
+        }
+    }
+
+    /// The comment style for an extension, if any.
+    pub fn lookup(&self, ext: &str) -> Option<LanguageProfile> {
+        self.entries
+            .binary_search_by(|(e, _)| e.as_str().cmp(ext))
+            .ok()
+            .map(|i| self.entries[i].1)
+    }
+}
+
+/// Maps a mapping-file style token to its profile.
+fn style_for_token(token: &str) -> Option<LanguageProfile> {
+    match token {
+        "/*" => Some(STYLE_C_LIKE),
+        "#" => Some(STYLE_HASH),
+        "//" => Some(STYLE_DOUBLE_SLASH),
+        "--" => Some(STYLE_DASH),
+        _ => None,
+    }
+}
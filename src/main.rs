@@ -12,11 +12,78 @@
 //    See the License for the specific language governing permissions and
 //    limitations under the License.
 
+mod cache;
+mod langmap;
+mod manifest;
+mod matcher;
+mod mmap;
+mod report;
+mod scheduler;
+mod stats;
+mod template;
+mod uring;
+
+use std::borrow::Cow;
+use std::collections::HashSet;
+use std::collections::hash_map::DefaultHasher;
+use std::hash::{Hash, Hasher};
+use std::io::{Read, Seek, SeekFrom, Write};
 use std::path::{Path, PathBuf};
-use std::sync::{Arc, Mutex, mpsc};
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::mpsc::{self, SyncSender};
+use std::sync::{Arc, Mutex};
 use std::thread;
+use std::time::Instant;
 use std::{fs, io, process};
 
+use cache::{CACHE_FILE, FileStamp, RunCache};
+use langmap::{ALL_STYLES, LanguageProfile, LanguageTable, STYLE_COUNT};
+use manifest::Manifest;
+use matcher::ExcludeMatcher;
+use mmap::Mmap;
+use report::{Format, Outcome, Reporter};
+use scheduler::{Batch, Entry, EntryPath, WorkQueue};
+use stats::{Phase, Stats};
+use template::Template;
+use uring::ProbeRing;
+
+/// paths moved per queue operation; amortizes dispatch overhead for
+/// directories full of tiny files
+const DISPATCH_BATCH: usize = 64;
+
+/// descriptors reserved out of the open-file limit for everything that
+/// is not a staged probe: stdio, per-worker ring fds, directory
+/// handles, the cache and manifest
+const FD_HEADROOM: u64 = 128;
+
+/// extra bytes read beyond the header length when probing a file head,
+/// leaving room for a shebang line and leading whitespace
+const PROBE_SLACK: usize = 512;
+
+/// bytes of the head inspected for NUL when sniffing out binary files
+const SNIFF_LEN: usize = 512;
+
+/// files at or above this size are memory-mapped on the rewrite path
+/// instead of read into the worker's heap buffer
+const MMAP_THRESHOLD: u64 = 1 << 20;
+
+/// in-flight rewrite jobs under --pipeline; bounds how much loaded file
+/// content can sit in the channel and pushes back on the read stage
+const PIPELINE_DEPTH: usize = 32;
+
+/// how often the adaptive controller re-samples throughput and moves the
+/// active worker count by one step
+const ADAPT_TICK_MS: u64 = 10;
+
+/// hard ceiling on the adaptive pool; parked workers cost only a stack,
+/// but there is no point spawning hundreds of them
+const MAX_ADAPTIVE_WORKERS: usize = 64;
+
+/// leading comment lines examined for an old header before giving up;
+/// any real license header fits with a wide margin, and the bound keeps
+/// a comment-only generated file from being scanned line by line
+const HEADER_SCAN_LINES: usize = 256;
+
 // ============================================================================
 // 1. Configuration
 // ============================================================================
@@ -30,10 +97,74 @@ ARGUMENTS:
                            If omitted, the current directory is used (.).
 
 OPTIONS:
-  -f, --file <PATH>        Path to the license header file. (Required)
-  -e, --exclude <PATTERN>  Exclude file/directory matching this pattern.
-                           Can be specified multiple times.
+  -f, --file <PATH>        Path to the license header file. (Required
+                           unless --rules is given.) The text may use
+                           {year}, {owner} and {filename}; {year} and
+                           {owner} are resolved once at startup,
+                           {filename} per file.
+      --rules <PATH>       Apply different headers to different subtrees
+                           in one pass. Each non-comment line of the file
+                           is one rule: 'header-file | scope-glob'
+                           optionally followed by '| exclude-glob' fields.
+                           The first rule whose scope matches a file (and
+                           whose excludes do not) wins; -f, if also
+                           given, acts as the catch-all after all rules.
+      --owner <NAME>       Value for the {owner} template variable.
+  -e, --exclude <PATTERN>  Exclude files/directories matching this pattern.
+                           Supports gitignore-style globs: * ? ** (e.g.
+                           '*.min.js', 'third_party/**'). Can be specified
+                           multiple times.
+      --gitignore          Also load exclude patterns from the .gitignore
+                           in each target directory (negations unsupported).
+      --since <REV>        Only process files git reports as changed
+                           since REV (plus untracked files), instead of
+                           walking the whole tree. Targets outside a git
+                           checkout fall back to the full walk with a
+                           warning.
+      --changed-only       Shorthand for --since HEAD: only files with
+                           uncommitted changes.
+  -L, --follow-links       Follow symlinked directories. Off by default;
+                           visited directories are tracked by inode so
+                           link cycles cannot loop the walk.
+      --langmap <PATH>     Load extra extension-to-comment-style mappings
+                           from a file, one 'ext=token' pair per line
+                           where the token is the comment leader: /*, //,
+                           # or -- (e.g. 'cmake=#'). Entries shadow the
+                           built-in table.
   -h, --help               Show this help message and exit.
+  -v, --verbose            Print a line per file instead of only the
+                           end-of-run summary.
+      --format <FMT>       Output format: 'text' (default) or 'json',
+                           which streams one NDJSON record per file plus
+                           a final summary record to stdout.
+      --check              Verify headers without modifying anything.
+                           Lists files missing a header and exits with
+                           status 1 if any are found.
+      --stats              Print per-phase timing, worker utilization,
+                           and I/O counters at exit.
+      --max-size <BYTES>   Skip files larger than this many bytes.
+                           No limit by default.
+      --pipeline <N>       Run rewrites on N dedicated threads fed by the
+                           worker pool, so workers go back to reading
+                           while writes are in flight. Helps when reads
+                           are slow (network filesystems). Off by
+                           default.
+      --no-cache           Do not read or write the incremental cache
+                           (.lice-cache) that skips unchanged files.
+      --resume <PATH>      Record per-file progress in a manifest at
+                           PATH and, when one from an interrupted run is
+                           already there, skip the files it settled. A
+                           manifest from a completed run is started
+                           over, so the same path can be passed every
+                           run.
+      --watch              Keep running and re-apply headers as files
+                           change (polls mtimes; see --interval).
+      --interval <MS>      Polling interval for --watch in milliseconds.
+                           Defaults to 500.
+  -j, --jobs <N>           Use exactly N worker threads. Without -j the
+                           pool sizes itself: it starts conservatively
+                           and grows or shrinks the active worker count
+                           during the run to match observed throughput.
 
 EXAMPLES:
   # Apply license to the current directory
@@ -42,11 +173,29 @@ EXAMPLES:
   # Apply to 'src' and 'include', excluding 'vendor' and 'build'
   lice -f HEADER.txt -e vendor -e build src include"#;
 
+#[derive(Clone)]
 struct Config {
     license_file: Option<String>,
+    rules_file: Option<String>,
+    langmap_file: Option<String>,
+    owner: Option<String>,
     excludes: Vec<String>,
     targets: Vec<PathBuf>,
+    since: Option<String>,
+    changed_only: bool,
     jobs: Option<usize>,
+    pipeline_threads: usize,
+    use_cache: bool,
+    resume_file: Option<String>,
+    load_gitignore: bool,
+    follow_links: bool,
+    verbose: bool,
+    format: Format,
+    check: bool,
+    stats: bool,
+    watch: bool,
+    watch_interval_ms: u64,
+    max_file_size: Option<u64>,
 }
 
 impl Config {
@@ -63,9 +212,26 @@ impl Config {
 
         let mut config = Config {
             license_file: None,
+            rules_file: None,
+            langmap_file: None,
+            owner: None,
             excludes: Vec::new(),
             targets: Vec::new(),
+            since: None,
+            changed_only: false,
             jobs: None,
+            pipeline_threads: 0,
+            use_cache: true,
+            resume_file: None,
+            load_gitignore: false,
+            follow_links: false,
+            verbose: false,
+            format: Format::Text,
+            check: false,
+            stats: false,
+            watch: false,
+            watch_interval_ms: 500,
+            max_file_size: None,
         };
 
         while let Some(arg) = args.next() {
@@ -74,10 +240,83 @@ impl Config {
                     let val = args.next().ok_or("-f/--file requires an argument")?;
                     config.license_file = Some(val);
                 }
+                "--since" => {
+                    let val = args.next().ok_or("--since requires an argument")?;
+                    config.since = Some(val);
+                }
+                "--changed-only" => {
+                    config.changed_only = true;
+                }
+                "--rules" => {
+                    let val = args.next().ok_or("--rules requires an argument")?;
+                    config.rules_file = Some(val);
+                }
                 "-e" | "--exclude" => {
                     let val = args.next().ok_or("-e/--exclude requires an argument")?;
                     config.excludes.push(val);
                 }
+                "--no-cache" => {
+                    config.use_cache = false;
+                }
+                "--resume" => {
+                    let val = args.next().ok_or("--resume requires an argument")?;
+                    config.resume_file = Some(val);
+                }
+                "--gitignore" => {
+                    config.load_gitignore = true;
+                }
+                "-L" | "--follow-links" => {
+                    config.follow_links = true;
+                }
+                "--langmap" => {
+                    let val = args.next().ok_or("--langmap requires an argument")?;
+                    config.langmap_file = Some(val);
+                }
+                "--owner" => {
+                    let val = args.next().ok_or("--owner requires an argument")?;
+                    config.owner = Some(val);
+                }
+                "-v" | "--verbose" => {
+                    config.verbose = true;
+                }
+                "--check" => {
+                    config.check = true;
+                }
+                "--format" => {
+                    let val = args.next().ok_or("--format requires an argument")?;
+                    config.format = match val.as_str() {
+                        "text" => Format::Text,
+                        "json" => Format::Json,
+                        other => return Err(format!("Unknown format: {}", other)),
+                    };
+                }
+                "--stats" => {
+                    config.stats = true;
+                }
+                "--watch" => {
+                    config.watch = true;
+                }
+                "--interval" => {
+                    let val = args.next().ok_or("--interval requires an argument")?;
+                    let num = val
+                        .parse::<u64>()
+                        .map_err(|_| "Invalid number for --interval")?;
+                    config.watch_interval_ms = num;
+                }
+                "--pipeline" => {
+                    let val = args.next().ok_or("--pipeline requires an argument")?;
+                    let num = val
+                        .parse::<usize>()
+                        .map_err(|_| "Invalid number for --pipeline")?;
+                    config.pipeline_threads = num;
+                }
+                "--max-size" => {
+                    let val = args.next().ok_or("--max-size requires an argument")?;
+                    let num = val
+                        .parse::<u64>()
+                        .map_err(|_| "Invalid number for --max-size")?;
+                    config.max_file_size = Some(num);
+                }
                 "-h" | "--help" => {
                     eprintln!("{}", USAGE_INFO);
                     process::exit(0);
@@ -97,8 +336,8 @@ impl Config {
     }
 
     fn validate(self) -> Result<Self, String> {
-        if self.license_file.is_none() {
-            return Err("Missing required argument: -f/--file".to_string());
+        if self.license_file.is_none() && self.rules_file.is_none() {
+            return Err("Missing required argument: -f/--file (or --rules)".to_string());
         }
         if self.targets.is_empty() {
             return Err("No target paths specified. Use '.' for current directory.".to_string());
@@ -107,77 +346,245 @@ impl Config {
     }
 }
 
-#[derive(Debug, Clone, Copy)]
-struct LanguageProfile {
-    /// comment start
-    /// e.g., "/*" or "" (line comment)
-    start: &'static str,
+// ============================================================================
+// 2. Core Engine
+// ============================================================================
 
-    /// comment prefix
-    /// e.g., " * " or "// "
-    prefix: &'static str,
+/// Per-worker scratch state, reused across every file a worker touches so
+/// steady-state processing performs no heap allocation per file.
+struct WorkerScratch {
+    /// pool of read buffers; probes in flight each hold one, and every
+    /// settled file hands its buffer back -- cleared, never shrunk
+    io_bufs: Vec<Vec<u8>>,
+    /// stamps of files verified during this run, merged once at worker exit
+    verified: Vec<(PathBuf, FileStamp)>,
+    /// buffered per-file log lines, flushed in chunks by the reporter
+    log: String,
+    /// staged --resume manifest records, appended a batch at a time
+    manifest: Vec<u8>,
+}
 
-    /// comment end
-    /// e.g., " */" or ""
-    end: &'static str,
+impl WorkerScratch {
+    fn new() -> Self {
+        Self {
+            io_bufs: Vec::new(),
+            verified: Vec::new(),
+            log: String::new(),
+            manifest: Vec::new(),
+        }
+    }
+}
+
+/// A file past the stat-side gates, opened and awaiting its head probe.
+/// With a ring, a whole dispatch batch of these completes under one
+/// syscall; without one each is read back-to-back.
+struct PendingProbe {
+    path: PathBuf,
+    rule: usize,
+    style: LanguageProfile,
+    stamp: Option<FileStamp>,
+    /// mode bits of the original, reapplied to the rewritten file
+    perms: fs::Permissions,
+    /// nlink > 1; the rewrite must keep the inode (see `rewrite_file`)
+    hardlinked: bool,
+    file_len: u64,
+    /// how much of the head the probe wants
+    probe_len: usize,
+    file: fs::File,
+    /// head bytes, filled by the probe read
+    buf: Vec<u8>,
+}
+
+/// Work shipped from the read stage to the rewrite stage under --pipeline:
+/// everything the rewrite needs with the content already resident.
+struct RewriteJob {
+    path: PathBuf,
+    rule: usize,
+    style: LanguageProfile,
+    perms: fs::Permissions,
+    hardlinked: bool,
+    data: JobData,
+}
+
+/// Resident file contents, however the read stage loaded them.
+enum JobData {
+    Heap(Vec<u8>),
+    Mapped(Mmap),
 }
 
-/// comment styles
-const STYLE_C_LIKE: LanguageProfile = LanguageProfile {
-    start: "/*\n",
-    prefix: " * ",
-    end: " */\n\n",
-};
-const STYLE_HASH: LanguageProfile = LanguageProfile {
-    start: "",
-    prefix: "# ",
-    end: "\n",
-}; // Python, Shell, Ruby
-const STYLE_DOUBLE_SLASH: LanguageProfile = LanguageProfile {
-    start: "",
-    prefix: "// ",
-    end: "\n",
-}; // Rust, Go, Java (line mode)
-const STYLE_DASH: LanguageProfile = LanguageProfile {
-    start: "",
-    prefix: "-- ",
-    end: "\n",
-}; // Lua, Haskell, SQL
-
-fn get_language_style(ext: &str) -> Option<LanguageProfile> {
-    match ext {
-        "c" | "h" | "cpp" | "hpp" | "css" => Some(STYLE_C_LIKE),
-        "rs" | "go" | "java" | "js" | "ts" => Some(STYLE_DOUBLE_SLASH),
-        "py" | "sh" | "rb" | "yaml" | "toml" => Some(STYLE_HASH),
-        "lua" | "hs" | "sql" => Some(STYLE_DASH),
-        _ => None, // not supported
+impl JobData {
+    fn as_slice(&self) -> &[u8] {
+        match self {
+            JobData::Heap(v) => v,
+            JobData::Mapped(m) => m.as_slice(),
+        }
     }
 }
 
-// ============================================================================
-// 2. Core Engine
-// ============================================================================
+/// One license configuration: a header applied to a scope of the tree.
+/// A plain -f run is a single rule with an empty scope; a --rules file
+/// contributes one per line, resolved first-match per file, so trees
+/// with different headers for different subtrees need one pass, not one
+/// run per header.
+struct Rule {
+    /// headers rendered once per comment style, indexed by `LanguageProfile::id`
+    rendered_headers: [String; STYLE_COUNT],
+    /// compiled template, kept only when it uses per-file variables
+    file_template: Option<Template>,
+    /// paths this rule covers; empty means everything
+    scope: ExcludeMatcher,
+    /// paths carved out of the scope, on top of the global -e set
+    excludes: ExcludeMatcher,
+}
 
 struct LiceEngine {
     config: Config,
-    raw_license_text: String,
+    /// license rules in priority order; files take the first match
+    rules: Vec<Rule>,
+    /// stamps of header-ok files from the previous run
+    cache: RunCache,
+    /// fingerprint of the license text, stored in the cache file
+    cache_token: u64,
+    /// stamps verified during this run, merged per worker at exit
+    verified: Mutex<Vec<(PathBuf, FileStamp)>>,
+    /// exclude patterns compiled once at startup
+    excludes: ExcludeMatcher,
+    /// extension dispatch table, built-ins merged with --langmap overrides
+    languages: LanguageTable,
+    /// (device, inode) pairs already claimed this run; dedups hardlink
+    /// farms and guards -L walks against symlink cycles
+    seen_inodes: Mutex<HashSet<(u64, u64)>>,
+    /// progress manifest under --resume, None otherwise
+    manifest: Option<Manifest>,
+    /// outcome counters and buffered per-file logging
+    reporter: Reporter,
+    /// per-phase timing and I/O counters, active under --stats
+    stats: Stats,
 }
 
 impl LiceEngine {
-    /// read license file and preprocess header
+    /// read license file(s) and preprocess headers
     fn new(config: Config) -> Result<Self, io::Error> {
-        let path = config.license_file.as_ref().unwrap(); // validate ensured 
-        let raw = fs::read_to_string(path)?;
+        // (header file, scope, excludes) specs: --rules entries first in
+        // file order, the -f header (if any) as the scope-less catch-all
+        let mut specs: Vec<(String, String, Vec<String>)> = Vec::new();
+        if let Some(path) = &config.rules_file {
+            load_rule_specs(Path::new(path), &mut specs)?;
+        }
+        if let Some(path) = &config.license_file {
+            specs.push((path.clone(), String::new(), Vec::new()));
+        }
+
+        // fingerprint every folded header plus its scope so a header
+        // edit -- or a year rollover, a changed --owner, a rule moved to
+        // a different subtree -- invalidates the cache
+        let mut hasher = DefaultHasher::new();
+        let mut rules = Vec::with_capacity(specs.len());
+        for (header_path, scope, rule_excludes) in &specs {
+            let raw = fs::read_to_string(header_path)?;
+            let template = Template::compile(&raw, config.owner.as_deref())
+                .map_err(|e| io::Error::new(io::ErrorKind::InvalidInput, e))?;
+            template.render("{filename}").hash(&mut hasher);
+            scope.hash(&mut hasher);
+            rule_excludes.hash(&mut hasher);
+
+            // render once per style; workers only ever borrow these. A
+            // template using {filename} differs per file instead and is
+            // rendered in apply_license.
+            let (rendered_headers, file_template) = if template.is_static() {
+                let text = template.static_text();
+                let headers = ALL_STYLES.map(|style| make_header_for_style(text, style));
+                (headers, None)
+            } else {
+                (ALL_STYLES.map(|_| String::new()), Some(template))
+            };
+            let scope_patterns: Vec<String> = if scope.is_empty() {
+                Vec::new()
+            } else {
+                vec![scope.clone()]
+            };
+            rules.push(Rule {
+                rendered_headers,
+                file_template,
+                scope: ExcludeMatcher::new(&scope_patterns),
+                excludes: ExcludeMatcher::new(rule_excludes),
+            });
+        }
+        let cache_token = hasher.finish();
+
+        let cache = if config.use_cache {
+            RunCache::load(Path::new(CACHE_FILE), cache_token)
+        } else {
+            RunCache::load(Path::new(""), cache_token) // empty
+        };
+
+        let mut languages = LanguageTable::builtin();
+        if let Some(map_path) = &config.langmap_file {
+            languages.load_overrides(Path::new(map_path));
+        }
+
+        let mut excludes = ExcludeMatcher::new(&config.excludes);
+        if config.load_gitignore {
+            for target in &config.targets {
+                excludes.add_ignore_file(&target.join(".gitignore"));
+            }
+        }
+
+        let manifest = match &config.resume_file {
+            Some(path) => Some(Manifest::open(Path::new(path))?),
+            None => None,
+        };
 
+        let reporter = Reporter::new(config.verbose, config.format);
+        let stats = Stats::new(config.stats);
         Ok(Self {
             config,
-            raw_license_text: raw,
+            rules,
+            cache,
+            cache_token,
+            verified: Mutex::new(Vec::new()),
+            excludes,
+            languages,
+            seen_inodes: Mutex::new(HashSet::new()),
+            manifest,
+            reporter,
+            stats,
         })
     }
 
+    /// Helper: pre-rendered header for a rule and style
+    fn header_for_style(&self, rule: usize, style: LanguageProfile) -> &str {
+        &self.rules[rule].rendered_headers[style.id]
+    }
+
+    /// Helper: the header for one file -- the pre-rendered style header,
+    /// or a fresh render when the rule's template uses {filename}
+    fn header_for_file(&self, rule: usize, path: &Path, style: LanguageProfile) -> Cow<'_, str> {
+        match &self.rules[rule].file_template {
+            Some(template) => {
+                let name = path.file_name().and_then(|s| s.to_str()).unwrap_or("");
+                Cow::Owned(make_header_for_style(&template.render(name), style))
+            }
+            None => Cow::Borrowed(self.header_for_style(rule, style)),
+        }
+    }
+
+    /// Helper: the first rule covering `path`, in priority order.
+    /// `None` means no configured header applies to this file.
+    fn rule_for_path(&self, path: &Path) -> Option<usize> {
+        let Some(s) = path.to_str() else {
+            // non-UTF8 paths cannot be glob-matched; only a catch-all applies
+            return self.rules.iter().position(|r| r.scope.is_empty());
+        };
+        self.rules
+            .iter()
+            .position(|r| (r.scope.is_empty() || r.scope.matches(s)) && !r.excludes.matches(s))
+    }
+
     /// entry
     fn run(self) -> io::Result<()> {
-        let num_threads = self.config.jobs.unwrap_or_else(|| {
+        let wall_start = Instant::now();
+        let base_threads = self.config.jobs.unwrap_or_else(|| {
             thread::available_parallelism()
                 .map(|n| n.get())
                 .unwrap_or(4)
@@ -186,178 +593,968 @@ impl LiceEngine {
         // ============================
         // Mode A: Single-thread
         // ============================
-        if num_threads == 1 {
-            println!("Running in single-threaded mode.");
+        if base_threads == 1 {
+            if !self.config.watch && self.config.format == Format::Text {
+                println!("Running in single-threaded mode.");
+            }
+            let mut scratch = WorkerScratch::new();
             self.traverse(|path| {
-                self.process_file(&path);
+                self.process_file(&path, &mut scratch, None, None);
             });
+            Reporter::flush(&mut scratch.log);
+            self.manifest_flush(&mut scratch);
+            self.print_summary();
+            self.stats
+                .print(wall_start.elapsed(), 1, self.config.format == Format::Json);
+            if self.config.use_cache {
+                if let Err(e) = self.cache.save(
+                    Path::new(CACHE_FILE),
+                    self.cache_token,
+                    scratch.verified.iter(),
+                    self.partial_run(),
+                ) {
+                    eprintln!("[WARN] Failed to write cache: {}", e);
+                }
+            }
+            self.manifest_finish();
+            self.exit_if_check_failed();
             return Ok(());
         }
 
         // ============================
         // Mode B: Multi-thread
         // ============================
+        // Without -j the pool sizes itself: spawn headroom beyond the
+        // core count (slow storage often wants more readers than cores),
+        // start with a conservative active set, and let a controller
+        // grow or shrink it against observed throughput. -j N pins the
+        // count exactly, as before.
+        let adaptive = self.config.jobs.is_none();
+        let num_threads = if adaptive {
+            // min, not clamp: on a >64-core box the floor (base_threads)
+            // would exceed the ceiling and Ord::clamp asserts min <= max
+            (base_threads * 2).min(MAX_ADAPTIVE_WORKERS)
+        } else {
+            base_threads
+        };
+        let initial_active = if adaptive {
+            base_threads.div_ceil(2).max(2).min(num_threads)
+        } else {
+            num_threads
+        };
+
+        // Staged probes hold an open descriptor each until their batch is
+        // flushed, so budget them against the file-descriptor limit: a
+        // wide pool staging full batches would blow through a 1024 soft
+        // cap and turn perfectly good files into EMFILE errors.
+        let fd_limit = raise_fd_limit();
+        let probe_cap =
+            (fd_limit.saturating_sub(FD_HEADROOM) as usize / num_threads).clamp(1, DISPATCH_BATCH);
+
         let shared_engine = Arc::new(self);
-        let (tx, rx) = mpsc::channel::<PathBuf>();
-        let shared_rx = Arc::new(Mutex::new(rx));
+        // seeds are the only paths that ever need an up-front stat
+        let entries = shared_engine.seed_entries();
+        let seed: Vec<Batch> = entries
+            .chunks(DISPATCH_BATCH)
+            .map(|chunk| chunk.to_vec())
+            .collect();
+        let queue = Arc::new(WorkQueue::new(num_threads, seed));
+        queue.set_active_limit(initial_active);
 
-        println!("Starting {} worker threads...", num_threads);
+        if !shared_engine.config.watch && shared_engine.config.format == Format::Text {
+            if adaptive {
+                println!(
+                    "Starting {} worker threads ({} active, adaptive)...",
+                    num_threads, initial_active
+                );
+            } else {
+                println!("Starting {} worker threads...", num_threads);
+            }
+        }
+
+        // Optional rewrite stage: a bounded channel of loaded contents
+        // feeding dedicated writer threads. The bound is the backpressure
+        // -- readers block once PIPELINE_DEPTH rewrites are in flight.
+        let pipeline_threads = shared_engine.config.pipeline_threads;
+        let (sink, rewrite_handles) = if pipeline_threads > 0 {
+            let (tx, rx) = mpsc::sync_channel::<RewriteJob>(PIPELINE_DEPTH);
+            let rx = Arc::new(Mutex::new(rx));
+            let mut rewrite_handles = Vec::with_capacity(pipeline_threads);
+            for _ in 0..pipeline_threads {
+                let thread_engine = Arc::clone(&shared_engine);
+                let thread_rx = Arc::clone(&rx);
+                rewrite_handles.push(thread::spawn(move || {
+                    thread_engine.rewrite_worker(&thread_rx);
+                }));
+            }
+            (Some(tx), rewrite_handles)
+        } else {
+            (None, Vec::new())
+        };
 
         let mut handles = Vec::with_capacity(num_threads);
-        for _ in 0..num_threads {
-            let thread_rx = Arc::clone(&shared_rx);
+        for worker_id in 0..num_threads {
+            let thread_queue = Arc::clone(&queue);
             let thread_engine = Arc::clone(&shared_engine);
+            let thread_sink = sink.clone();
 
             handles.push(thread::spawn(move || {
-                loop {
-                    // get the job
-                    let path = match thread_rx.lock().unwrap().recv() {
-                        Ok(p) => p,
-                        Err(_) => break, // exit
-                    };
-                    // process
-                    thread_engine.process_file(&path);
-                }
+                thread_engine.worker_loop(
+                    worker_id,
+                    &thread_queue,
+                    thread_sink.as_ref(),
+                    probe_cap,
+                );
             }));
         }
 
-        // main thread
-        shared_engine.traverse(|path| {
-            if let Err(e) = tx.send(path) {
-                eprintln!("Failed to send task: {}", e);
-            }
+        // the controller runs beside the pool, nudging the gate each tick
+        let ctl_done = Arc::new(AtomicBool::new(false));
+        let controller = adaptive.then(|| {
+            let thread_engine = Arc::clone(&shared_engine);
+            let thread_queue = Arc::clone(&queue);
+            let thread_done = Arc::clone(&ctl_done);
+            thread::spawn(move || {
+                thread_engine.adapt_workers(&thread_queue, initial_active, &thread_done);
+            })
         });
 
-        drop(tx);
-
         for h in handles {
             h.join().unwrap();
         }
+        ctl_done.store(true, Ordering::SeqCst);
+        if let Some(h) = controller {
+            h.join().unwrap();
+        }
+        // hang up the channel so the rewrite stage drains and exits
+        drop(sink);
+        for h in rewrite_handles {
+            h.join().unwrap();
+        }
+
+        shared_engine.print_summary();
+        shared_engine.stats.print(
+            wall_start.elapsed(),
+            num_threads + pipeline_threads,
+            shared_engine.config.format == Format::Json,
+        );
+
+        if shared_engine.config.use_cache {
+            let verified = shared_engine.verified.lock().unwrap();
+            if let Err(e) = shared_engine.cache.save(
+                Path::new(CACHE_FILE),
+                shared_engine.cache_token,
+                verified.iter(),
+                shared_engine.partial_run(),
+            ) {
+                eprintln!("[WARN] Failed to write cache: {}", e);
+            }
+        }
+        shared_engine.manifest_finish();
+        shared_engine.exit_if_check_failed();
         Ok(())
     }
 
+    /// End-of-run totals: a summary record in json mode, a sentence in
+    /// text mode (suppressed on quiet watch passes).
+    fn print_summary(&self) {
+        match self.config.format {
+            Format::Json => println!("{}", self.reporter.summary_json()),
+            Format::Text => {
+                if !self.config.watch || self.reporter.has_activity() {
+                    println!("Done: {}", self.reporter.summary());
+                }
+            }
+        }
+    }
+
+    /// CI gate: a --check run with offenders fails the process.
+    fn exit_if_check_failed(&self) {
+        if self.config.check && self.reporter.missing_count() > 0 {
+            process::exit(1);
+        }
+    }
+
+    /// Worker: pop batches until the queue reports global completion.
+    /// Verified stamps accumulate locally and merge once at exit, so the
+    /// shared list is never touched on the per-file path.
+    fn worker_loop(
+        &self,
+        worker_id: usize,
+        queue: &WorkQueue,
+        sink: Option<&SyncSender<RewriteJob>>,
+        probe_cap: usize,
+    ) {
+        let mut scratch = WorkerScratch::new();
+        // one probe ring per worker; None outside Linux or on old kernels,
+        // in which case probes stay on the blocking path
+        let mut ring = ProbeRing::new(DISPATCH_BATCH as u32);
+        loop {
+            let wait = self.stats.start();
+            let batch = queue.pop(worker_id);
+            self.stats.finish(Phase::Idle, wait);
+            let Some(batch) = batch else { break };
+            self.execute_batch(
+                worker_id,
+                batch,
+                queue,
+                &mut scratch,
+                sink,
+                &mut ring,
+                probe_cap,
+            );
+            queue.complete();
+        }
+        Reporter::flush(&mut scratch.log);
+        self.manifest_flush(&mut scratch);
+        self.verified.lock().unwrap().extend(scratch.verified);
+    }
+
+    /// Adaptive controller: hill-climbs the active worker count. Every
+    /// tick it samples how many files settled since the last one; while
+    /// the rate holds or improves it keeps stepping in the current
+    /// direction, and a clear drop reverses the step. The walk settles
+    /// into oscillating around whatever count saturates the I/O
+    /// subsystem -- above the core count on slow storage, below it when
+    /// extra readers only contend.
+    fn adapt_workers(&self, queue: &WorkQueue, initial: usize, done: &AtomicBool) {
+        let tick = std::time::Duration::from_millis(ADAPT_TICK_MS);
+        let max = queue.worker_count();
+        let mut active = initial;
+        let mut step = 1isize;
+        let mut last_settled = self.reporter.settled();
+        let mut last_rate = 0;
+        while !done.load(Ordering::Relaxed) {
+            thread::sleep(tick);
+            let settled = self.reporter.settled();
+            let rate = settled - last_settled;
+            last_settled = settled;
+            // reverse on a >10% drop; smaller wobble is sampling noise
+            if rate * 10 < last_rate * 9 {
+                step = -step;
+            }
+            last_rate = rate;
+            let next = (active as isize + step).clamp(2, max as isize) as usize;
+            if next != active {
+                active = next;
+                queue.set_active_limit(active);
+            }
+        }
+    }
+
+    /// Rewrite-stage worker under --pipeline: drains loaded contents off
+    /// the channel and performs the split + write, leaving the reading
+    /// workers free to keep I/O in flight.
+    fn rewrite_worker(&self, jobs: &Mutex<mpsc::Receiver<RewriteJob>>) {
+        let mut scratch = WorkerScratch::new();
+        loop {
+            let job = match jobs.lock().unwrap().recv() {
+                Ok(job) => job,
+                Err(_) => break, // read stage done and channel drained
+            };
+            let header = self.header_for_file(job.rule, &job.path, job.style);
+            if let Err(e) = self.rewrite_file(
+                &job.path,
+                job.style,
+                &header,
+                job.data.as_slice(),
+                job.perms,
+                job.hardlinked,
+                &mut scratch,
+            ) {
+                self.reporter
+                    .record(&mut scratch.log, Outcome::Error, &job.path, &e.to_string());
+            }
+        }
+        Reporter::flush(&mut scratch.log);
+        self.manifest_flush(&mut scratch);
+        self.verified.lock().unwrap().extend(scratch.verified);
+    }
+
+    /// Drains one batch: expands directories into new batches, processes files.
+    /// Children discovered along the way are re-batched so every queue
+    /// operation moves up to `DISPATCH_BATCH` paths at once. Entries carry
+    /// the file type captured at discovery, so no path is stat'd again here.
+    fn execute_batch(
+        &self,
+        worker_id: usize,
+        batch: Batch,
+        queue: &WorkQueue,
+        scratch: &mut WorkerScratch,
+        sink: Option<&SyncSender<RewriteJob>>,
+        ring: &mut Option<ProbeRing>,
+        probe_cap: usize,
+    ) {
+        let mut children: Vec<Entry> = Vec::with_capacity(DISPATCH_BATCH);
+        let mut probes: Vec<PendingProbe> = Vec::new();
+
+        for item in batch {
+            match item {
+                Entry::Dir(dir) => {
+                    let path = dir.materialize();
+                    if self.is_excluded(&path) || self.dir_already_seen(&path) {
+                        continue;
+                    }
+                    let t0 = self.stats.start();
+                    match fs::read_dir(&path) {
+                        Ok(entries) => {
+                            // children share this one prefix allocation
+                            let parent: Arc<Path> = path.into();
+                            let mut discovered = 0u64;
+                            for entry in entries.flatten() {
+                                let Some(child) =
+                                    classify_dir_entry(&parent, &entry, self.config.follow_links)
+                                else {
+                                    continue;
+                                };
+                                children.push(child);
+                                discovered += 1;
+                                if children.len() == DISPATCH_BATCH {
+                                    queue.push(worker_id, std::mem::take(&mut children));
+                                }
+                            }
+                            self.stats.count(&self.stats.dirs_read, 1);
+                            self.stats.count(&self.stats.paths_discovered, discovered);
+                        }
+                        Err(e) => eprintln!("Failed to read dir {:?}: {}", path, e),
+                    }
+                    self.stats.finish(Phase::Traverse, t0);
+                }
+                Entry::File(file) => {
+                    let path = file.materialize();
+                    if self.is_excluded(&path) {
+                        continue;
+                    }
+                    let pending = ring.is_some().then_some(&mut probes);
+                    self.process_file(&path, scratch, sink, pending);
+                    // the staged descriptors must fit the worker's share
+                    // of the fd budget; flush early once they do not
+                    if probes.len() >= probe_cap {
+                        self.flush_probes(ring, &mut probes, scratch, sink);
+                    }
+                }
+            }
+        }
+
+        // a batch holds at most DISPATCH_BATCH files, so the staged
+        // probes always fit the ring in one submission
+        self.flush_probes(ring, &mut probes, scratch, sink);
+        self.manifest_flush(scratch);
+
+        if !children.is_empty() {
+            queue.push(worker_id, children);
+        }
+    }
+
+    /// Seed entries for the walk: the configured targets, or -- under
+    /// --since/--changed-only -- only the paths git reports as changed
+    /// beneath each directory target. A target git cannot answer for
+    /// (no checkout, no git, unknown revision) warns and falls back to
+    /// its full walk, so the flags never silently miss files.
+    fn seed_entries(&self) -> Vec<Entry> {
+        let since = match (&self.config.since, self.config.changed_only) {
+            (Some(rev), _) => Some(rev.as_str()),
+            (None, true) => Some("HEAD"),
+            (None, false) => None,
+        };
+        let mut entries = Vec::new();
+        for target in &self.config.targets {
+            if let Some(rev) = since {
+                if target.is_dir() {
+                    match git_changed_paths(target, rev) {
+                        Some(paths) => {
+                            entries.extend(paths.into_iter().map(classify_path));
+                            continue;
+                        }
+                        None => eprintln!(
+                            "[WARN] {:?}: cannot list changes since '{}' from git; \
+                             walking the whole tree",
+                            target, rev
+                        ),
+                    }
+                }
+            }
+            entries.push(classify_path(target.clone()));
+        }
+        entries
+    }
+
     // Helper: accepts a closure
     fn traverse<F>(&self, mut callback: F)
     where
         F: FnMut(PathBuf), // this closure accepts a PathBuf and ret ()
     {
-        let mut stack = self.config.targets.to_vec();
-
-        while let Some(path) = stack.pop() {
-            if self.is_excluded(&path) {
-                continue;
-            }
+        let mut stack: Vec<Entry> = self.seed_entries();
 
-            if path.is_dir() {
-                match fs::read_dir(&path) {
-                    Ok(entries) => {
-                        for entry in entries.flatten() {
-                            stack.push(entry.path());
+        while let Some(item) = stack.pop() {
+            match item {
+                Entry::Dir(dir) => {
+                    let path = dir.materialize();
+                    if self.is_excluded(&path) || self.dir_already_seen(&path) {
+                        continue;
+                    }
+                    match fs::read_dir(&path) {
+                        Ok(entries) => {
+                            let parent: Arc<Path> = path.into();
+                            for entry in entries.flatten() {
+                                if let Some(child) =
+                                    classify_dir_entry(&parent, &entry, self.config.follow_links)
+                                {
+                                    stack.push(child);
+                                }
+                            }
                         }
+                        Err(e) => eprintln!("Failed to read dir {:?}: {}", path, e),
                     }
-                    Err(e) => eprintln!("Failed to read dir {:?}: {}", path, e),
                 }
-            } else {
-                callback(path);
+                Entry::File(file) => {
+                    let path = file.materialize();
+                    if self.is_excluded(&path) {
+                        continue;
+                    }
+                    callback(path);
+                }
             }
         }
     }
 
     /// Iterative DFS
-    fn process_file(&self, path: &PathBuf) {
+    fn process_file(
+        &self,
+        path: &PathBuf,
+        scratch: &mut WorkerScratch,
+        sink: Option<&SyncSender<RewriteJob>>,
+        pending: Option<&mut Vec<PendingProbe>>,
+    ) {
+        // --resume: the manifest says the interrupted run already
+        // settled this path; drop it before even a stat
+        if let Some(manifest) = &self.manifest {
+            if manifest.is_done(path) {
+                self.reporter.record(
+                    &mut scratch.log,
+                    Outcome::Skipped,
+                    path,
+                    "Already settled per --resume manifest",
+                );
+                return;
+            }
+        }
+
         // check ext
         let ext = match path.extension().and_then(|s| s.to_str()) {
             Some(e) => e,
-            None => return, // no ext, ignore
+            None => {
+                // no ext, ignore silently
+                self.reporter
+                    .record(&mut scratch.log, Outcome::Skipped, path, "");
+                return;
+            }
         };
 
-        match get_language_style(ext) {
+        match self.languages.lookup(ext) {
             Some(style) => {
-                if let Err(e) = self.apply_license(path, style) {
-                    eprintln!("Error processing {:?}: {}", path, e);
+                let Some(rule) = self.rule_for_path(path) else {
+                    self.reporter.record(
+                        &mut scratch.log,
+                        Outcome::Skipped,
+                        path,
+                        "No license rule covers this path",
+                    );
+                    return;
+                };
+                // with a ring the probe is only staged here; the whole
+                // batch of reads is submitted together in flush_probes
+                let result = match pending {
+                    Some(pending) => self.open_probe(path, rule, style, scratch).map(|job| {
+                        if let Some(job) = job {
+                            pending.push(job);
+                        }
+                    }),
+                    None => self.apply_license(path, rule, style, scratch, sink),
+                };
+                if let Err(e) = result {
+                    self.reporter
+                        .record(&mut scratch.log, Outcome::Error, path, &e.to_string());
                 }
             }
             None => {
-                eprintln!("[WARN] Ignoring unsupported file type: {:?}", path)
+                self.reporter.record(
+                    &mut scratch.log,
+                    Outcome::Skipped,
+                    path,
+                    "Ignoring unsupported file type",
+                );
+            }
+        }
+    }
+
+    /// core business, blocking path: probe the head synchronously, then
+    /// settle the file
+    fn apply_license(
+        &self,
+        path: &Path,
+        rule: usize,
+        style: LanguageProfile,
+        scratch: &mut WorkerScratch,
+        sink: Option<&SyncSender<RewriteJob>>,
+    ) -> io::Result<()> {
+        let Some(mut job) = self.open_probe(path, rule, style, scratch)? else {
+            return Ok(());
+        };
+        let t_read = self.stats.start();
+        let result = read_probe_sync(&mut job);
+        self.stats.finish(Phase::Read, t_read);
+        result?;
+        self.finish_probe(job, scratch, sink);
+        Ok(())
+    }
+
+    /// The stat-side gates of the fast path -- hardlink claim, freshness
+    /// cache, size cutoff -- ending with the open. Returns None when the
+    /// file settles without reading a byte.
+    fn open_probe(
+        &self,
+        path: &Path,
+        rule: usize,
+        style: LanguageProfile,
+        scratch: &mut WorkerScratch,
+    ) -> io::Result<Option<PendingProbe>> {
+        // Fastest path: unchanged since the last run means the header we
+        // confirmed back then is still in place -- one stat, no open.
+        let meta = fs::metadata(path)?;
+
+        // Hardlink farms alias one physical file under many names; claim
+        // the inode once so it is read and rewritten exactly once per run
+        // (and two workers cannot race on it through different paths).
+        // Singly-linked files -- the usual case -- never touch the lock.
+        let hardlinked = link_count(&meta) > 1;
+        if hardlinked {
+            if let Some(id) = file_identity(&meta) {
+                if !self.seen_inodes.lock().unwrap().insert(id) {
+                    self.reporter.record(
+                        &mut scratch.log,
+                        Outcome::Skipped,
+                        path,
+                        "Already processed via another hardlink",
+                    );
+                    return Ok(None);
+                }
+            }
+        }
+
+        let stamp = FileStamp::from_metadata(&meta);
+        if let Some(stamp) = stamp {
+            if self.cache.is_fresh(path, stamp) {
+                scratch.verified.push((path.to_path_buf(), stamp));
+                self.reporter
+                    .record(&mut scratch.log, Outcome::Ok, path, "");
+                self.manifest_mark(scratch, path);
+                return Ok(None);
+            }
+        }
+
+        // size cutoff: a stray multi-GB artifact must not dominate the run
+        if let Some(limit) = self.config.max_file_size {
+            if meta.len() > limit {
+                self.reporter.record(
+                    &mut scratch.log,
+                    Outcome::Skipped,
+                    path,
+                    "Ignoring file over --max-size",
+                );
+                return Ok(None);
             }
         }
+
+        let probe_len = self.header_for_file(rule, path, style).len() + PROBE_SLACK;
+        let file = fs::File::open(path)?;
+        let buf = scratch.io_bufs.pop().unwrap_or_default();
+        Ok(Some(PendingProbe {
+            path: path.to_path_buf(),
+            rule,
+            style,
+            stamp,
+            perms: meta.permissions(),
+            hardlinked,
+            file_len: meta.len(),
+            probe_len,
+            file,
+            buf,
+        }))
     }
 
-    /// core business
-    fn apply_license(&self, path: &Path, style: LanguageProfile) -> io::Result<()> {
-        let content = fs::read_to_string(path)?;
+    /// Settles a batch of staged probes. With a ring the whole batch of
+    /// head reads goes down in one submission; without one (or after a
+    /// ring failure) each falls back to a blocking read.
+    fn flush_probes(
+        &self,
+        ring: &mut Option<ProbeRing>,
+        probes: &mut Vec<PendingProbe>,
+        scratch: &mut WorkerScratch,
+        sink: Option<&SyncSender<RewriteJob>>,
+    ) {
+        if probes.is_empty() {
+            return;
+        }
 
-        // generate header
-        let header = self.make_header_for_style(&self.raw_license_text, style);
+        let mut results: Vec<Option<i32>> = Vec::new();
+        let mut poisoned = false;
+        if let Some(r) = ring.as_mut() {
+            results.resize(probes.len(), None);
+            let t_read = self.stats.start();
+            for (i, job) in probes.iter_mut().enumerate() {
+                job.buf.resize(job.probe_len, 0);
+                r.push_read(raw_fd(&job.file), &mut job.buf, i as u64);
+            }
+            let submitted = r.submit_and_wait(|tag, res| {
+                if let Some(slot) = results.get_mut(tag as usize) {
+                    *slot = Some(res);
+                }
+            });
+            self.stats.finish(Phase::Read, t_read);
+            if submitted.is_err() {
+                // the ring is wedged; finish this run on the blocking path
+                *ring = None;
+                poisoned = true;
+            }
+        }
+
+        for (i, mut job) in probes.drain(..).enumerate() {
+            // a ring result is complete when it filled the probe or hit
+            // EOF; anything else (error, short read) is re-read plainly
+            let done = match results.get(i).copied().flatten() {
+                Some(res) if res >= 0 => {
+                    job.buf.truncate(res as usize);
+                    res as usize == job.probe_len || res as u64 >= job.file_len
+                }
+                _ => false,
+            };
+            if !done {
+                if poisoned {
+                    // the failed submission may have left this read in
+                    // flight: the kernel still owns the buffer and can
+                    // write into it at any time. Leak it -- never back
+                    // into the pool -- and re-read into a fresh one.
+                    std::mem::forget(std::mem::take(&mut job.buf));
+                }
+                let t_read = self.stats.start();
+                let result = read_probe_sync(&mut job);
+                self.stats.finish(Phase::Read, t_read);
+                if let Err(e) = result {
+                    self.reporter.record(
+                        &mut scratch.log,
+                        Outcome::Error,
+                        &job.path,
+                        &e.to_string(),
+                    );
+                    scratch.io_bufs.push(std::mem::take(&mut job.buf));
+                    continue;
+                }
+            }
+            self.finish_probe(job, scratch, sink);
+        }
+    }
+
+    /// Settles one probed file: header compare, binary sniff, --check,
+    /// and the rewrite slow path. Reports its own errors -- by now the
+    /// path has been claimed and its buffer must find its way home.
+    fn finish_probe(
+        &self,
+        job: PendingProbe,
+        scratch: &mut WorkerScratch,
+        sink: Option<&SyncSender<RewriteJob>>,
+    ) {
+        let PendingProbe {
+            path,
+            rule,
+            style,
+            stamp,
+            perms,
+            hardlinked,
+            file_len,
+            probe_len: _,
+            mut file,
+            buf: mut bytes,
+        } = job;
+        let header = self.header_for_file(rule, &path, style);
+        self.stats.count(&self.stats.bytes_read, bytes.len() as u64);
 
-        // handle with shebang
-        let offset = if content.starts_with("#!") {
-            content.find('\n').map(|i| i + 1).unwrap_or(0)
+        let t_check = self.stats.start();
+        let probe_ok = header_probe_matches(&bytes, &header);
+        self.stats.finish(Phase::HeaderCheck, t_check);
+
+        if probe_ok {
+            self.reporter
+                .record(&mut scratch.log, Outcome::Ok, &path, "");
+            self.manifest_mark(scratch, &path);
+            if let Some(stamp) = stamp {
+                scratch.verified.push((path, stamp));
+            }
+            scratch.io_bufs.push(bytes);
+            return;
+        }
+
+        // Binary sniff: a NUL in the head means this is not source text
+        // (generated blobs with source extensions); bail before reading
+        // the rest of the file.
+        if bytes[..bytes.len().min(SNIFF_LEN)].contains(&0) {
+            self.reporter.record(
+                &mut scratch.log,
+                Outcome::Skipped,
+                &path,
+                "Ignoring binary file",
+            );
+            self.manifest_mark(scratch, &path);
+            scratch.io_bufs.push(bytes);
+            return;
+        }
+
+        // --check: the header is missing; report it and stop here, before
+        // the remainder of the file is read or anything is opened for write
+        if self.config.check {
+            self.reporter
+                .record(&mut scratch.log, Outcome::Missing, &path, "");
+            scratch.io_bufs.push(bytes);
+            return;
+        }
+
+        // Slow path: the header is missing or stale, load the remainder.
+        // Everything below works on raw bytes: no UTF-8 validation pass,
+        // and files with stray non-UTF-8 sequences (vendored Latin-1
+        // comments and the like) are rewritten instead of erroring out.
+        //
+        // Large files are memory-mapped rather than heap-read: the body
+        // slices below then stream straight from the page cache during the
+        // rewrite, so per-worker peak memory stays flat however big the
+        // file is. Small files keep the plain read -- a map/unmap pair
+        // costs more than reading a few KB into the reused buffer.
+        //
+        // Hardlinked files are never mapped: their rewrite truncates the
+        // inode in place, and a mapping of that same inode would then
+        // read back the truncated pages instead of the original content.
+        // They take the heap read, which copies before the truncate.
+        let t_read = self.stats.start();
+        let before = bytes.len();
+        let mapping = if file_len >= MMAP_THRESHOLD && !hardlinked {
+            Mmap::map(&file, file_len as usize)
         } else {
-            0
+            None
         };
-        let body_to_check = &content[offset..];
+        if mapping.is_none() {
+            // a ring read leaves the descriptor's offset untouched, so
+            // position it just past the head before pulling the rest
+            let read_rest = file
+                .seek(SeekFrom::Start(bytes.len() as u64))
+                .and_then(|_| file.read_to_end(&mut bytes));
+            if let Err(e) = read_rest {
+                self.reporter
+                    .record(&mut scratch.log, Outcome::Error, &path, &e.to_string());
+                scratch.io_bufs.push(std::mem::take(&mut bytes));
+                return;
+            }
+        }
+        drop(file); // the mapping outlives the descriptor
+        self.stats.finish(Phase::Read, t_read);
+        let loaded = mapping.as_ref().map_or(bytes.len(), |m| m.as_slice().len());
+        self.stats
+            .count(&self.stats.bytes_read, loaded.saturating_sub(before) as u64);
 
-        // check if exists
-        if body_to_check.trim_start().starts_with(header.trim()) {
-            println!(" License OK: {:?}", path);
-            return Ok(());
+        let data = match mapping {
+            Some(m) => {
+                scratch.io_bufs.push(std::mem::take(&mut bytes));
+                JobData::Mapped(m)
+            }
+            None => JobData::Heap(bytes),
+        };
+
+        // Pipeline mode: the content is resident, so hand the rewrite to
+        // the write stage and go back to reading. Send blocks once the
+        // channel is full -- that is the backpressure keeping loaded
+        // contents bounded.
+        if let Some(sink) = sink {
+            let _ = sink.send(RewriteJob {
+                path,
+                rule,
+                style,
+                perms,
+                hardlinked,
+                data,
+            });
+            return;
         }
 
-        let new_content = if !style.start.is_empty() {
+        if let Err(e) = self.rewrite_file(
+            &path,
+            style,
+            &header,
+            data.as_slice(),
+            perms,
+            hardlinked,
+            scratch,
+        ) {
+            self.reporter
+                .record(&mut scratch.log, Outcome::Error, &path, &e.to_string());
+        }
+        if let JobData::Heap(buf) = data {
+            scratch.io_bufs.push(buf); // hand the reused buffer back
+        }
+    }
+
+    /// The write half of the slow path: splits `content` around any stale
+    /// header and emits the new file. Runs inline on the worker normally,
+    /// or on a rewrite-stage thread under --pipeline.
+    fn rewrite_file(
+        &self,
+        path: &Path,
+        style: LanguageProfile,
+        header: &str,
+        content: &[u8],
+        perms: fs::Permissions,
+        hardlinked: bool,
+        scratch: &mut WorkerScratch,
+    ) -> io::Result<()> {
+        // Work out what to emit as slices into `content` — no intermediate
+        // concatenated buffer, so peak memory stays at one copy of the file.
+        let (shebang, body): (Option<&[u8]>, &[u8]) = if !style.start.is_empty() {
             // block comments
-            if content.trim_start().starts_with(style.start) {
-                if let Some(end_idx) = content.find(style.end) {
-                    let body = &content[end_idx + style.end.len()..];
-                    format!("{}{}", header, body.trim_start())
+            if content
+                .trim_ascii_start()
+                .starts_with(style.start.as_bytes())
+            {
+                if let Some(end_idx) = find_bytes(content, style.end.as_bytes()) {
+                    (
+                        None,
+                        content[end_idx + style.end.len()..].trim_ascii_start(),
+                    )
                 } else {
                     // malformed file
                     eprintln!(
                         "[WARN] Skipping {:?}: Unclosed block comment detected.",
                         path
                     );
+                    self.reporter
+                        .record(&mut scratch.log, Outcome::Skipped, path, "");
                     return Ok(()); // continue
                 }
             } else {
-                format!("{}{}", header, content)
+                (None, content)
             }
         } else {
             // line comments
-            self.replace_line_comment_header(&content, &header, style)
+            self.line_comment_split(content, style)
         };
 
-        fs::write(path, new_content)?;
+        // Write to a temp file in the same directory, then rename over the
+        // original: a crash or OOM-kill mid-write can no longer leave a
+        // truncated source behind. The pieces are a handful of large slices,
+        // so plain write_all calls suffice -- no intermediate buffer.
+        //
+        // The rename must land on the real file: renaming over a symlinked
+        // path would swap the link itself for a regular file and leave its
+        // target unstamped, so links are resolved first.
+        //
+        // A hardlinked file is the one case that cannot take the rename at
+        // all: it would detach this name from the link family, leaving the
+        // sibling names -- already reported done via the inode claim -- on
+        // the old headerless inode. Those files are truncated and written
+        // in place instead, giving up mid-write atomicity for them only.
+        let target: Cow<Path> =
+            if fs::symlink_metadata(path).is_ok_and(|m| m.file_type().is_symlink()) {
+                Cow::Owned(fs::canonicalize(path)?)
+            } else {
+                Cow::Borrowed(path)
+            };
+        let tmp_path = tmp_path_for(&target);
+        let t_write = self.stats.start();
+        let written =
+            shebang.map_or(0, |sb| sb.len() as u64 + 1) + header.len() as u64 + body.len() as u64;
+        let result = (|| -> io::Result<()> {
+            let mut out = if hardlinked {
+                fs::File::create(&*target)?
+            } else {
+                fs::File::create(&tmp_path)?
+            };
+            if let Some(sb) = shebang {
+                out.write_all(sb)?;
+                out.write_all(b"\n")?;
+            }
+            out.write_all(header.as_bytes())?;
+            out.write_all(body)?;
+            // line-comment files are guaranteed a trailing newline, as before
+            if style.start.is_empty() && !body.ends_with(b"\n") {
+                out.write_all(b"\n")?;
+            }
+            if hardlinked {
+                // in place: the inode already carries the right mode bits
+                return Ok(());
+            }
+            // the temp file was created with default mode bits; carry the
+            // original's over so an executable script stays executable
+            out.set_permissions(perms)?;
+            drop(out);
+            fs::rename(&tmp_path, &*target)
+        })();
+        self.stats.finish(Phase::Write, t_write);
+        if result.is_err() {
+            // best effort: do not leave temp droppings next to sources
+            if !hardlinked {
+                let _ = fs::remove_file(&tmp_path);
+            }
+            return result;
+        }
+        self.stats.count(&self.stats.bytes_written, written);
+
+        // re-stat: the rewrite gave the file a new mtime/size
+        if let Ok(meta) = fs::metadata(path) {
+            if let Some(stamp) = FileStamp::from_metadata(&meta) {
+                scratch.verified.push((path.to_path_buf(), stamp));
+            }
+        }
+        self.reporter
+            .record(&mut scratch.log, Outcome::Updated, path, "");
+        self.manifest_mark(scratch, path);
         Ok(())
     }
 
-    /// handle line comment header replacement
-    fn replace_line_comment_header(
+    /// Finds where the retained body begins in a line-comment file.
+    /// Returns the shebang line (without its newline) and the body tail,
+    /// both borrowed from `content` — a single offset scan, no line Vec,
+    /// no joined String.
+    fn line_comment_split<'a>(
         &self,
-        content: &str,
-        header: &str,
+        content: &'a [u8],
         style: LanguageProfile,
-    ) -> String {
-        let lines: Vec<&str> = content.lines().collect();
-        let mut keep_start_idx = 0;
+    ) -> (Option<&'a [u8]>, &'a [u8]) {
+        let mut pos = 0;
         let mut shebang_line = None;
 
         // check shebang
-        if let Some(first_line) = lines.first() {
-            if first_line.starts_with("#!") {
-                shebang_line = Some(*first_line);
-                keep_start_idx = 1;
-            }
+        if content.starts_with(b"#!") {
+            let line_end = next_line_end(content, pos);
+            shebang_line = Some(strip_newline(&content[..line_end]));
+            pos = line_end;
         }
 
-        // scan for "old"
-        while keep_start_idx < lines.len() {
-            let line = lines[keep_start_idx];
-            let trimmed = line.trim();
+        // scan for "old", at most HEADER_SCAN_LINES deep: a real header
+        // ends long before that, and a pathological file (a generated
+        // dump that is comment lines all the way down) must not be
+        // scanned -- or stripped -- end to end
+        let scan_start = pos;
+        let mut scanned = 0;
+        while pos < content.len() {
+            if scanned == HEADER_SCAN_LINES {
+                // no header boundary within the bound: treat the file as
+                // headerless and keep every scanned line in the body
+                return (shebang_line, &content[scan_start..]);
+            }
+            let line_end = next_line_end(content, pos);
+            let trimmed = strip_newline(&content[pos..line_end]).trim_ascii();
 
-            if trimmed.starts_with(style.prefix.trim()) {
-                keep_start_idx += 1;
+            if trimmed.starts_with(style.prefix.trim().as_bytes()) {
+                pos = line_end;
+                scanned += 1;
             } else if trimmed.is_empty() {
-                keep_start_idx += 1;
+                pos = line_end;
                 break;
             } else {
                 // reach the code
@@ -365,72 +1562,381 @@ impl LiceEngine {
             }
         }
 
-        let body = lines[keep_start_idx..].join("\n");
-
-        let mut out = String::new();
+        (shebang_line, &content[pos..])
+    }
 
-        if let Some(sb) = shebang_line {
-            out.push_str(sb);
-            out.push('\n');
+    /// Loop guard for -L: a symlinked directory can make the same physical
+    /// directory reachable twice, or cyclically. One stat per directory
+    /// keeps the walk finite. Plain walks cannot loop, so without -L this
+    /// is a single branch.
+    fn dir_already_seen(&self, path: &Path) -> bool {
+        if !self.config.follow_links {
+            return false;
         }
-
-        out.push_str(header);
-        out.push_str(&body);
-
-        // add \n to eof
-        if !out.ends_with('\n') {
-            out.push('\n');
+        let Ok(meta) = fs::metadata(path) else {
+            return false;
+        };
+        match file_identity(&meta) {
+            Some(id) => !self.seen_inodes.lock().unwrap().insert(id),
+            None => false,
         }
+    }
 
-        out
+    /// Helper: true when this run deliberately visits only a subset of
+    /// the tree -- git selection or resume skips -- so the cache save
+    /// must merge over the loaded entries instead of replacing them.
+    fn partial_run(&self) -> bool {
+        self.config.since.is_some()
+            || self.config.changed_only
+            || self.manifest.as_ref().is_some_and(|m| m.resumed())
     }
 
-    /// Helper: generate header from style and raw str
-    fn make_header_for_style(&self, raw: &str, style: LanguageProfile) -> String {
-        let mut out = String::new();
-        if !style.start.is_empty() {
-            out.push_str(style.start);
+    /// Helper: stages one settled-path manifest record when --resume is
+    /// active; the worker's batchful is appended once it grows large
+    fn manifest_mark(&self, scratch: &mut WorkerScratch, path: &Path) {
+        if self.manifest.is_some() {
+            Manifest::push(&mut scratch.manifest, path);
+            if scratch.manifest.len() >= manifest::FLUSH_THRESHOLD {
+                self.manifest_flush(scratch);
+            }
         }
+    }
 
-        for line in raw.lines() {
-            let trimmed = line.trim_end();
-            out.push_str(style.prefix);
-            out.push_str(trimmed);
-            out.push('\n');
+    /// Helper: appends the worker's staged manifest records
+    fn manifest_flush(&self, scratch: &mut WorkerScratch) {
+        if let Some(manifest) = &self.manifest {
+            if let Err(e) = manifest.flush(&mut scratch.manifest) {
+                eprintln!("[WARN] Failed to write manifest: {}", e);
+                scratch.manifest.clear();
+            }
         }
+    }
 
-        if !style.end.is_empty() {
-            out.push_str(style.end);
-        } else {
-            // line comment just add \n
-            out.push('\n');
+    /// Helper: seals the manifest at the end of a completed run, so the
+    /// next --resume on the same file starts fresh
+    fn manifest_finish(&self) {
+        if let Some(manifest) = &self.manifest {
+            if let Err(e) = manifest.finish() {
+                eprintln!("[WARN] Failed to finalize manifest: {}", e);
+            }
         }
-        out
     }
 
     /// Helper: if a path is excluded
     fn is_excluded(&self, path: &Path) -> bool {
-        for component in path.components() {
-            match component.as_os_str().to_str() {
-                Some(s) => {
-                    for pattern in &self.config.excludes {
-                        if s == pattern {
-                            return true;
-                        }
-                    }
-                }
-                None => {
-                    eprintln!("[WARN] Skipping non-UTF8 path: {:?}", path);
-                    return true;
+        if self.excludes.is_empty() {
+            return false;
+        }
+        match path.to_str() {
+            Some(s) => self.excludes.matches(s),
+            None => {
+                eprintln!("[WARN] Skipping non-UTF8 path: {:?}", path);
+                true
+            }
+        }
+    }
+}
+
+/// Helper: parses a --rules file into (header file, scope, excludes)
+/// specs, in file order. One rule per line, '|'-separated: the header
+/// file, the scope glob, then any number of exclude globs. Blank lines
+/// and lines starting with '#' are comments; bad lines warn and are
+/// ignored, like the language map loader.
+fn load_rule_specs(path: &Path, specs: &mut Vec<(String, String, Vec<String>)>) -> io::Result<()> {
+    let text = fs::read_to_string(path)?;
+    for line in text.lines() {
+        let line = line.trim();
+        if line.is_empty() || line.starts_with('#') {
+            continue;
+        }
+        let mut fields = line.split('|').map(str::trim);
+        let header = fields.next().unwrap_or("");
+        let scope = fields.next();
+        if header.is_empty() || scope.is_none() {
+            eprintln!(
+                "[WARN] Ignoring rule line (want 'header-file | scope'): {}",
+                line
+            );
+            continue;
+        }
+        let excludes = fields
+            .filter(|f| !f.is_empty())
+            .map(str::to_string)
+            .collect();
+        specs.push((header.to_string(), scope.unwrap().to_string(), excludes));
+    }
+    Ok(())
+}
+
+/// Helper: the files git reports as changed since `rev` under `dir` --
+/// committed or staged or worktree differences plus untracked files,
+/// minus deletions. Paths come back joined onto `dir`. `None` means git
+/// could not answer (no checkout, no git binary, unknown revision) and
+/// the caller should walk the tree instead.
+fn git_changed_paths(dir: &Path, rev: &str) -> Option<Vec<PathBuf>> {
+    let git = |args: &[&str]| -> Option<Vec<u8>> {
+        let out = process::Command::new("git")
+            .arg("-C")
+            .arg(dir)
+            .args(args)
+            .output()
+            .ok()?;
+        out.status.success().then_some(out.stdout)
+    };
+
+    // --relative keeps paths rooted at `dir`, -z makes them unambiguous,
+    // --diff-filter=d drops deletions (there is nothing left to stamp)
+    let diffed = git(&[
+        "diff",
+        "--relative",
+        "--name-only",
+        "--diff-filter=d",
+        "-z",
+        rev,
+        "--",
+        ".",
+    ])?;
+    let untracked = git(&["ls-files", "--others", "--exclude-standard", "-z"])?;
+
+    let mut paths = Vec::new();
+    for chunk in diffed
+        .split(|&b| b == 0)
+        .chain(untracked.split(|&b| b == 0))
+    {
+        if chunk.is_empty() {
+            continue;
+        }
+        match std::str::from_utf8(chunk) {
+            Ok(rel) => paths.push(dir.join(rel)),
+            Err(_) => eprintln!(
+                "[WARN] Skipping non-UTF8 path from git: {:?}",
+                String::from_utf8_lossy(chunk)
+            ),
+        }
+    }
+    Some(paths)
+}
+
+/// Helper: classify a path with one stat; only used for seed targets
+fn classify_path(path: PathBuf) -> Entry {
+    if path.is_dir() {
+        Entry::Dir(EntryPath::seed(path))
+    } else {
+        Entry::File(EntryPath::seed(path))
+    }
+}
+
+/// Helper: classify a directory child from the type `read_dir` already has
+/// (free via d_type on most filesystems). The entry is stored as the
+/// leaf name against the directory's interned prefix -- discovery
+/// allocates no full path. Symlinks cost one stat to see what they
+/// point at; links to directories are descended only under
+/// `follow_links`, links to files are always processed. `None` means the
+/// entry is dropped from the walk.
+fn classify_dir_entry(
+    parent: &Arc<Path>,
+    entry: &fs::DirEntry,
+    follow_links: bool,
+) -> Option<Entry> {
+    let compact = || EntryPath::child(parent, entry.file_name());
+    match entry.file_type() {
+        Ok(ft) if ft.is_dir() => Some(Entry::Dir(compact())),
+        Ok(ft) if ft.is_file() => Some(Entry::File(compact())),
+        Ok(ft) if ft.is_symlink() => {
+            let path = entry.path();
+            if path.is_dir() {
+                if follow_links {
+                    Some(Entry::Dir(compact()))
+                } else {
+                    None
                 }
+            } else if path.is_file() {
+                Some(Entry::File(compact()))
+            } else {
+                None // dangling link
+            }
+        }
+        _ => {
+            if entry.path().is_dir() {
+                Some(Entry::Dir(compact()))
+            } else {
+                Some(Entry::File(compact()))
             }
         }
-        false
     }
 }
 
+/// Helper: the portable head probe -- a plain bounded read from the start
+fn read_probe_sync(job: &mut PendingProbe) -> io::Result<()> {
+    job.buf.clear();
+    job.file.seek(SeekFrom::Start(0))?;
+    Read::by_ref(&mut job.file)
+        .take(job.probe_len as u64)
+        .read_to_end(&mut job.buf)?;
+    Ok(())
+}
+
+/// Helper: raw descriptor for the probe ring; never called on platforms
+/// without one
+#[cfg(unix)]
+fn raw_fd(file: &fs::File) -> i32 {
+    use std::os::unix::io::AsRawFd;
+    file.as_raw_fd()
+}
+#[cfg(not(unix))]
+fn raw_fd(_file: &fs::File) -> i32 {
+    -1
+}
+
+/// Helper: (device, inode) pair naming the physical file behind a path
+#[cfg(unix)]
+fn file_identity(meta: &fs::Metadata) -> Option<(u64, u64)> {
+    use std::os::unix::fs::MetadataExt;
+    Some((meta.dev(), meta.ino()))
+}
+#[cfg(not(unix))]
+fn file_identity(_meta: &fs::Metadata) -> Option<(u64, u64)> {
+    None
+}
+
+/// Helper: raises the soft open-file limit to the hard limit and
+/// returns the result. Staged probes hold one descriptor each, and a
+/// wide pool under the common 1024 soft cap would run into EMFILE
+/// mid-batch; the hard limit is usually far higher and raising the
+/// soft one to it needs no privilege. Failures just return the current
+/// soft limit -- the probe budget below adapts to whatever this yields.
+#[cfg(unix)]
+fn raise_fd_limit() -> u64 {
+    #[repr(C)]
+    struct Rlimit {
+        cur: u64,
+        max: u64,
+    }
+    unsafe extern "C" {
+        fn getrlimit(resource: i32, rlim: *mut Rlimit) -> i32;
+        fn setrlimit(resource: i32, rlim: *const Rlimit) -> i32;
+    }
+    #[cfg(target_os = "linux")]
+    const RLIMIT_NOFILE: i32 = 7;
+    #[cfg(not(target_os = "linux"))]
+    const RLIMIT_NOFILE: i32 = 8; // macOS and the BSDs
+
+    let mut lim = Rlimit { cur: 0, max: 0 };
+    if unsafe { getrlimit(RLIMIT_NOFILE, &mut lim) } != 0 {
+        return 1024; // the conventional default; stay conservative
+    }
+    if lim.cur < lim.max {
+        let raised = Rlimit {
+            cur: lim.max,
+            max: lim.max,
+        };
+        if unsafe { setrlimit(RLIMIT_NOFILE, &raised) } == 0 {
+            return raised.cur;
+        }
+    }
+    lim.cur
+}
+#[cfg(not(unix))]
+fn raise_fd_limit() -> u64 {
+    u64::MAX
+}
+
+/// Helper: hardlink count; 1 on platforms without the concept
+#[cfg(unix)]
+fn link_count(meta: &fs::Metadata) -> u64 {
+    use std::os::unix::fs::MetadataExt;
+    meta.nlink()
+}
+#[cfg(not(unix))]
+fn link_count(_meta: &fs::Metadata) -> u64 {
+    1
+}
+
+/// Helper: temp file name beside `path` for the atomic write-then-rename
+fn tmp_path_for(path: &Path) -> PathBuf {
+    let mut name = std::ffi::OsString::from(".");
+    if let Some(file_name) = path.file_name() {
+        name.push(file_name);
+    }
+    name.push(".lice-tmp");
+    path.with_file_name(name)
+}
+
+/// Helper: offset just past the newline terminating the line at `pos`
+/// (or the end of the buffer for an unterminated last line)
+fn next_line_end(content: &[u8], pos: usize) -> usize {
+    match content[pos..].iter().position(|&b| b == b'\n') {
+        Some(i) => pos + i + 1,
+        None => content.len(),
+    }
+}
+
+/// Helper: drop a trailing '\n' from a line slice
+fn strip_newline(line: &[u8]) -> &[u8] {
+    match line.last() {
+        Some(b'\n') => &line[..line.len() - 1],
+        _ => line,
+    }
+}
+
+/// Helper: first occurrence of `needle` in `haystack`
+fn find_bytes(haystack: &[u8], needle: &[u8]) -> Option<usize> {
+    if needle.is_empty() {
+        return Some(0);
+    }
+    haystack.windows(needle.len()).position(|w| w == needle)
+}
+
+/// Helper: does the file head already start with the header?
+/// Pure byte comparison (no UTF-8 validation), tolerating a shebang line
+/// and leading whitespace before the header, same as the rewrite path.
+fn header_probe_matches(head: &[u8], header: &str) -> bool {
+    let mut body = head;
+
+    // handle with shebang
+    if body.starts_with(b"#!") {
+        match body.iter().position(|&b| b == b'\n') {
+            Some(i) => body = &body[i + 1..],
+            None => return false,
+        }
+    }
+
+    while let Some((first, rest)) = body.split_first() {
+        if first.is_ascii_whitespace() {
+            body = rest;
+        } else {
+            break;
+        }
+    }
+
+    body.starts_with(header.trim().as_bytes())
+}
+
+/// Helper: generate header from style and raw str
+fn make_header_for_style(raw: &str, style: LanguageProfile) -> String {
+    let mut out = String::new();
+    if !style.start.is_empty() {
+        out.push_str(style.start);
+    }
+
+    for line in raw.lines() {
+        let trimmed = line.trim_end();
+        out.push_str(style.prefix);
+        out.push_str(trimmed);
+        out.push('\n');
+    }
+
+    if !style.end.is_empty() {
+        out.push_str(style.end);
+    } else {
+        // line comment just add \n
+        out.push('\n');
+    }
+    out
+}
+
 // ============================================================================
-// 3. 程序入口 (Main)
+// 4. 程序入口 (Main)
 // ============================================================================
 
 fn main() {
@@ -441,13 +1947,42 @@ fn main() {
         process::exit(1);
     });
 
-    // 2. init engine
+    // 2. watch mode: poll forever, one incremental pass per tick.
+    // The mtime cache makes quiet passes stat-only, so per-save latency
+    // is the poll interval plus one file's worth of work.
+    if config.watch {
+        if config.check {
+            eprintln!("Error: --watch and --check cannot be combined");
+            process::exit(1);
+        }
+        if config.format == Format::Text {
+            println!(
+                "Watching {:?} (polling every {} ms, Ctrl-C to stop)...",
+                config.targets, config.watch_interval_ms
+            );
+        }
+        let interval = std::time::Duration::from_millis(config.watch_interval_ms);
+        loop {
+            // a fresh engine per pass picks up the cache the last pass wrote
+            let engine = LiceEngine::new(config.clone()).unwrap_or_else(|e| {
+                eprintln!("Failed to initialize engine: {}", e);
+                process::exit(1);
+            });
+            if let Err(e) = engine.run() {
+                eprintln!("Fatal error: {}", e);
+                process::exit(1);
+            }
+            thread::sleep(interval);
+        }
+    }
+
+    // 3. init engine
     let engine = LiceEngine::new(config).unwrap_or_else(|e| {
         eprintln!("Failed to initialize engine: {}", e);
         process::exit(1);
     });
 
-    // 3. execute
+    // 4. execute
     if let Err(e) = engine.run() {
         eprintln!("Fatal error: {}", e);
         process::exit(1);
@@ -0,0 +1,159 @@
+//    Copyright 2025 Karesis
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+//! Append-only run manifest for resumable huge-tree runs.
+//!
+//! Every settled file appends one compact binary record as the run
+//! goes, so a run killed at 90% (preemption, OOM) restarts with
+//! `--resume` and skips straight to the remaining 10%. Records are
+//! staged in per-worker buffers and appended a batch at a time under
+//! one lock -- the per-file hot path only pushes bytes locally. A clean
+//! exit appends a run-complete sentinel; resuming from a manifest that
+//! carries one starts the run (and the file) over, so a fixed manifest
+//! path can be passed to every nightly invocation.
+
+use std::collections::HashSet;
+use std::fs;
+use std::io::{self, Seek, SeekFrom, Write};
+use std::path::{Path, PathBuf};
+use std::sync::Mutex;
+
+/// file identification header
+const MAGIC: &[u8] = b"lice-manifest 1\n";
+
+/// record: a path settled successfully this run
+const TAG_DONE: u8 = 1;
+
+/// sentinel: the run reached its end; the manifest describes a
+/// completed run, not an interrupted one
+const TAG_COMPLETE: u8 = 0xFF;
+
+/// a worker's staged records are appended once they grow past this
+pub const FLUSH_THRESHOLD: usize = 8 * 1024;
+
+/// The manifest: the skip set loaded from an interrupted run, plus the
+/// append handle this run's records go down.
+///
+/// Record layout after the magic line: one tag byte, a little-endian
+/// u32 path length, then the path bytes (UTF-8; unrepresentable paths
+/// are simply not recorded, same as the cache). The complete sentinel
+/// is `TAG_COMPLETE` with length zero.
+pub struct Manifest {
+    /// paths the interrupted run already settled
+    done: HashSet<PathBuf>,
+    out: Mutex<fs::File>,
+}
+
+impl Manifest {
+    /// Opens `path` for resuming: previously recorded paths load into
+    /// the skip set and new records append behind them, after any torn
+    /// trailing record from the crash is truncated away. A manifest
+    /// ending in the complete sentinel is a finished run and is started
+    /// over; so is a missing or unrecognizable file (a lost manifest
+    /// costs re-processing, never correctness).
+    pub fn open(path: &Path) -> io::Result<Self> {
+        let existing = fs::read(path).unwrap_or_default();
+        let (done, valid_len, complete) = parse(&existing);
+
+        let fresh = valid_len == 0 || complete;
+        let out = if fresh {
+            let mut f = fs::File::create(path)?;
+            f.write_all(MAGIC)?;
+            f
+        } else {
+            let mut f = fs::OpenOptions::new().write(true).open(path)?;
+            f.set_len(valid_len as u64)?;
+            f.seek(SeekFrom::End(0))?;
+            f
+        };
+
+        Ok(Self {
+            done: if fresh { HashSet::new() } else { done },
+            out: Mutex::new(out),
+        })
+    }
+
+    /// True if the interrupted run already settled `path`.
+    pub fn is_done(&self, path: &Path) -> bool {
+        self.done.contains(path)
+    }
+
+    /// True when records from an interrupted run were loaded, i.e. this
+    /// run skips files instead of visiting the whole tree.
+    pub fn resumed(&self) -> bool {
+        !self.done.is_empty()
+    }
+
+    /// Stages one settled-path record in `buf`, a worker's local
+    /// manifest buffer; no I/O happens here.
+    pub fn push(buf: &mut Vec<u8>, path: &Path) {
+        let Some(s) = path.to_str() else { return };
+        buf.push(TAG_DONE);
+        buf.extend_from_slice(&(s.len() as u32).to_le_bytes());
+        buf.extend_from_slice(s.as_bytes());
+    }
+
+    /// Appends a worker's staged records under one lock and clears them.
+    pub fn flush(&self, buf: &mut Vec<u8>) -> io::Result<()> {
+        if buf.is_empty() {
+            return Ok(());
+        }
+        let mut out = self.out.lock().unwrap();
+        out.write_all(buf)?;
+        buf.clear();
+        Ok(())
+    }
+
+    /// Marks the run complete; the next --resume on this file starts a
+    /// fresh run instead of skipping everything.
+    pub fn finish(&self) -> io::Result<()> {
+        let mut out = self.out.lock().unwrap();
+        out.write_all(&[TAG_COMPLETE, 0, 0, 0, 0])?;
+        out.flush()
+    }
+}
+
+/// Walks the records, returning the settled set, the offset of the last
+/// well-formed record (0 for a missing or foreign file), and whether
+/// the complete sentinel was seen. Anything malformed ends the walk --
+/// a crash mid-append leaves at most one torn record, at the tail.
+fn parse(bytes: &[u8]) -> (HashSet<PathBuf>, usize, bool) {
+    let mut done = HashSet::new();
+    if !bytes.starts_with(MAGIC) {
+        return (done, 0, false);
+    }
+
+    let mut pos = MAGIC.len();
+    let mut complete = false;
+    while pos < bytes.len() {
+        if pos + 5 > bytes.len() {
+            break; // torn tag/length
+        }
+        let tag = bytes[pos];
+        let len = u32::from_le_bytes(bytes[pos + 1..pos + 5].try_into().unwrap()) as usize;
+        if pos + 5 + len > bytes.len() {
+            break; // torn path
+        }
+        if tag == TAG_COMPLETE && len == 0 {
+            complete = true;
+        } else if tag == TAG_DONE {
+            if let Ok(s) = std::str::from_utf8(&bytes[pos + 5..pos + 5 + len]) {
+                done.insert(PathBuf::from(s));
+            }
+        }
+        // unknown tags skip cleanly, for the next format revision
+        pos += 5 + len;
+    }
+    (done, pos, complete)
+}
@@ -0,0 +1,166 @@
+//    Copyright 2025 Karesis
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+use std::collections::HashSet;
+use std::path::Path;
+
+/// Exclude patterns compiled once at startup.
+///
+/// Three tiers, cheapest first:
+/// - exact component names (`vendor`, `build`) live in a hash set and cost
+///   one lookup per path component — the common `-e name` case;
+/// - bare glob patterns (`*.min.js`) are matched against each component;
+/// - patterns containing `/` (`third_party/**`) are matched against the
+///   path, starting at any component boundary (gitignore-style anchoring).
+///
+/// Glob syntax: `*` and `?` never cross a `/`; `**` crosses anything.
+pub struct ExcludeMatcher {
+    exact_components: HashSet<Vec<u8>>,
+    component_globs: Vec<Vec<u8>>,
+    path_globs: Vec<Vec<u8>>,
+}
+
+impl ExcludeMatcher {
+    pub fn new(patterns: &[String]) -> Self {
+        let mut matcher = Self {
+            exact_components: HashSet::new(),
+            component_globs: Vec::new(),
+            path_globs: Vec::new(),
+        };
+        for pattern in patterns {
+            matcher.add(pattern);
+        }
+        matcher
+    }
+
+    /// Adds one pattern. A trailing `/` (gitignore "directory only") is
+    /// dropped: excluding the directory path prunes the whole subtree.
+    pub fn add(&mut self, pattern: &str) {
+        let pattern = pattern.strip_suffix('/').unwrap_or(pattern);
+        if pattern.is_empty() {
+            return;
+        }
+
+        let bytes = pattern.as_bytes().to_vec();
+        if pattern.contains('/') {
+            self.path_globs.push(bytes);
+        } else if pattern.contains('*') || pattern.contains('?') {
+            self.component_globs.push(bytes);
+        } else {
+            self.exact_components.insert(bytes);
+        }
+    }
+
+    /// Reads non-comment, non-negated lines of a `.gitignore`-format file.
+    /// Negations (`!pattern`) are not supported and reported once each.
+    pub fn add_ignore_file(&mut self, path: &Path) {
+        let text = match std::fs::read_to_string(path) {
+            Ok(t) => t,
+            Err(_) => return, // missing ignore file is not an error
+        };
+        for line in text.lines() {
+            let line = line.trim();
+            if line.is_empty() || line.starts_with('#') {
+                continue;
+            }
+            if let Some(negated) = line.strip_prefix('!') {
+                eprintln!(
+                    "[WARN] {:?}: ignoring unsupported negation '!{}'",
+                    path, negated
+                );
+                continue;
+            }
+            self.add(line);
+        }
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.exact_components.is_empty()
+            && self.component_globs.is_empty()
+            && self.path_globs.is_empty()
+    }
+
+    /// True if any tier matches `path`. Non-UTF8 components are handled by
+    /// the caller (they are skipped with a warning before reaching here).
+    pub fn matches(&self, path: &str) -> bool {
+        let bytes = path.as_bytes();
+
+        if !self.exact_components.is_empty() || !self.component_globs.is_empty() {
+            for component in bytes.split(|&b| b == b'/') {
+                if self.exact_components.contains(component) {
+                    return true;
+                }
+                for glob in &self.component_globs {
+                    if glob_match(glob, component) {
+                        return true;
+                    }
+                }
+            }
+        }
+
+        for glob in &self.path_globs {
+            // unanchored: the pattern may start at any component boundary
+            let mut start = 0;
+            loop {
+                if glob_match(glob, &bytes[start..]) {
+                    return true;
+                }
+                match bytes[start..].iter().position(|&b| b == b'/') {
+                    Some(i) => start += i + 1,
+                    None => break,
+                }
+            }
+        }
+
+        false
+    }
+}
+
+/// Glob match over raw bytes. `*` and `?` stop at `/`; `**` matches across
+/// separators (a following `/` is folded in so `a/**/b` also matches `a/b`).
+fn glob_match(pattern: &[u8], text: &[u8]) -> bool {
+    match pattern.first() {
+        None => text.is_empty(),
+        Some(b'*') if pattern.get(1) == Some(&b'*') => {
+            let rest = &pattern[2..];
+            let rest = rest.strip_prefix(b"/").unwrap_or(rest);
+            for i in 0..=text.len() {
+                if glob_match(rest, &text[i..]) {
+                    return true;
+                }
+            }
+            false
+        }
+        Some(b'*') => {
+            let rest = &pattern[1..];
+            for i in 0..=text.len() {
+                if glob_match(rest, &text[i..]) {
+                    return true;
+                }
+                if text.get(i) == Some(&b'/') {
+                    return false;
+                }
+            }
+            false
+        }
+        Some(b'?') => match text.first() {
+            Some(&c) if c != b'/' => glob_match(&pattern[1..], &text[1..]),
+            _ => false,
+        },
+        Some(&p) => match text.first() {
+            Some(&c) if c == p => glob_match(&pattern[1..], &text[1..]),
+            _ => false,
+        },
+    }
+}
@@ -0,0 +1,100 @@
+//    Copyright 2025 Karesis
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+//! Minimal read-only memory mapping.
+//!
+//! Bound directly against the platform C library (which Rust binaries link
+//! anyway) so no external crate is needed. On non-unix targets `map`
+//! returns `None` and callers fall back to heap reads.
+
+#[cfg(unix)]
+mod imp {
+    use std::fs::File;
+    use std::os::unix::io::AsRawFd;
+
+    const PROT_READ: i32 = 1;
+    const MAP_PRIVATE: i32 = 2;
+
+    unsafe extern "C" {
+        fn mmap(addr: *mut u8, len: usize, prot: i32, flags: i32, fd: i32, offset: i64) -> *mut u8;
+        fn munmap(addr: *mut u8, len: usize) -> i32;
+    }
+
+    /// A read-only private mapping of a whole file, unmapped on drop.
+    pub struct Mmap {
+        ptr: *mut u8,
+        len: usize,
+    }
+
+    // the mapping is immutable and owned; moving it across threads is fine
+    unsafe impl Send for Mmap {}
+    unsafe impl Sync for Mmap {}
+
+    impl Mmap {
+        /// Maps `len` bytes of `file`; `None` on failure or empty files,
+        /// letting the caller fall back to a plain read.
+        pub fn map(file: &File, len: usize) -> Option<Self> {
+            if len == 0 {
+                return None;
+            }
+            let ptr = unsafe {
+                mmap(
+                    std::ptr::null_mut(),
+                    len,
+                    PROT_READ,
+                    MAP_PRIVATE,
+                    file.as_raw_fd(),
+                    0,
+                )
+            };
+            if ptr as isize == -1 {
+                None
+            } else {
+                Some(Self { ptr, len })
+            }
+        }
+
+        pub fn as_slice(&self) -> &[u8] {
+            unsafe { std::slice::from_raw_parts(self.ptr, self.len) }
+        }
+    }
+
+    impl Drop for Mmap {
+        fn drop(&mut self) {
+            unsafe {
+                munmap(self.ptr, self.len);
+            }
+        }
+    }
+}
+
+#[cfg(not(unix))]
+mod imp {
+    use std::fs::File;
+
+    /// Stub for targets without the unix mapping calls.
+    pub struct Mmap;
+
+    impl Mmap {
+        pub fn map(_file: &File, _len: usize) -> Option<Self> {
+            None
+        }
+
+        pub fn as_slice(&self) -> &[u8] {
+            &[]
+        }
+    }
+}
+
+pub use imp::Mmap;
@@ -0,0 +1,231 @@
+//    Copyright 2025 Karesis
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+use std::io::Write;
+use std::path::Path;
+use std::sync::atomic::{AtomicU64, Ordering};
+
+/// flush a worker's log buffer once it grows past this
+const FLUSH_THRESHOLD: usize = 8 * 1024;
+
+/// How results are written to stdout.
+#[derive(Clone, Copy, PartialEq)]
+pub enum Format {
+    /// human-readable lines and a summary sentence
+    Text,
+    /// one compact NDJSON record per outcome plus a summary record;
+    /// stable field names, safe to scrape
+    Json,
+}
+
+/// What happened to one file.
+pub enum Outcome {
+    /// header already present (or cached as present)
+    Ok,
+    /// header was written
+    Updated,
+    /// unsupported or extension-less file, not touched
+    Skipped,
+    /// processing failed
+    Error,
+    /// --check only: header absent, file left untouched
+    Missing,
+}
+
+impl Outcome {
+    fn name(&self) -> &'static str {
+        match self {
+            Outcome::Ok => "ok",
+            Outcome::Updated => "updated",
+            Outcome::Skipped => "skipped",
+            Outcome::Error => "error",
+            Outcome::Missing => "missing",
+        }
+    }
+}
+
+/// Progress reporting without per-file lock traffic.
+///
+/// Counters are atomics bumped on every outcome. Per-file lines exist only
+/// in verbose mode and are appended to a per-worker buffer that is flushed
+/// in chunks, so the stdout lock is taken once per several hundred files
+/// instead of once per file. Errors always go to stderr immediately.
+pub struct Reporter {
+    verbose: bool,
+    format: Format,
+    ok: AtomicU64,
+    updated: AtomicU64,
+    skipped: AtomicU64,
+    errors: AtomicU64,
+    missing: AtomicU64,
+}
+
+impl Reporter {
+    pub fn new(verbose: bool, format: Format) -> Self {
+        Self {
+            verbose,
+            format,
+            ok: AtomicU64::new(0),
+            updated: AtomicU64::new(0),
+            skipped: AtomicU64::new(0),
+            errors: AtomicU64::new(0),
+            missing: AtomicU64::new(0),
+        }
+    }
+
+    /// Records one outcome; `buf` is the calling worker's log buffer.
+    pub fn record(&self, buf: &mut String, outcome: Outcome, path: &Path, detail: &str) {
+        let counter = match outcome {
+            Outcome::Ok => &self.ok,
+            Outcome::Updated => &self.updated,
+            Outcome::Skipped => &self.skipped,
+            Outcome::Error => &self.errors,
+            Outcome::Missing => &self.missing,
+        };
+        counter.fetch_add(1, Ordering::Relaxed);
+
+        if self.format == Format::Json {
+            // every outcome becomes one buffered record: cheap enough to
+            // leave on everywhere, and errors still echo to stderr so an
+            // interactive run cannot miss them
+            if let Outcome::Error = outcome {
+                eprintln!("Error processing {:?}: {}", path, detail);
+            }
+            push_json_record(buf, &outcome, path, detail);
+            if buf.len() >= FLUSH_THRESHOLD {
+                Self::flush(buf);
+            }
+            return;
+        }
+
+        match outcome {
+            // errors are rare and must never be lost to a buffer
+            Outcome::Error => eprintln!("Error processing {:?}: {}", path, detail),
+            // offenders are the whole point of --check: always listed
+            Outcome::Missing => {
+                buf.push_str(&format!("Missing license: {:?}\n", path));
+            }
+            Outcome::Ok if self.verbose => {
+                buf.push_str(&format!(" License OK: {:?}\n", path));
+            }
+            Outcome::Updated if self.verbose => {
+                buf.push_str(&format!(" License written: {:?}\n", path));
+            }
+            Outcome::Skipped if self.verbose && !detail.is_empty() => {
+                buf.push_str(&format!("[WARN] {}: {:?}\n", detail, path));
+            }
+            _ => {}
+        }
+
+        if buf.len() >= FLUSH_THRESHOLD {
+            Self::flush(buf);
+        }
+    }
+
+    /// Writes out a worker's buffered lines under one stdout lock.
+    pub fn flush(buf: &mut String) {
+        if buf.is_empty() {
+            return;
+        }
+        let mut out = std::io::stdout().lock();
+        let _ = out.write_all(buf.as_bytes());
+        buf.clear();
+    }
+
+    /// One-line totals, printed at the end of every run.
+    pub fn summary(&self) -> String {
+        let mut line = format!(
+            "{} ok, {} updated, {} skipped, {} errors",
+            self.ok.load(Ordering::Relaxed),
+            self.updated.load(Ordering::Relaxed),
+            self.skipped.load(Ordering::Relaxed),
+            self.errors.load(Ordering::Relaxed),
+        );
+        let missing = self.missing.load(Ordering::Relaxed);
+        if missing > 0 {
+            line.push_str(&format!(", {} missing", missing));
+        }
+        line
+    }
+
+    /// The summary as one NDJSON record, mirroring `summary`.
+    pub fn summary_json(&self) -> String {
+        format!(
+            concat!(
+                r#"{{"type":"summary","ok":{},"updated":{},"#,
+                r#""skipped":{},"errors":{},"missing":{}}}"#
+            ),
+            self.ok.load(Ordering::Relaxed),
+            self.updated.load(Ordering::Relaxed),
+            self.skipped.load(Ordering::Relaxed),
+            self.errors.load(Ordering::Relaxed),
+            self.missing.load(Ordering::Relaxed),
+        )
+    }
+
+    /// Total outcomes recorded so far, across all workers. Cheap enough
+    /// (five relaxed loads) to sample on a timer; the adaptive controller
+    /// uses its rate of change as the throughput signal.
+    pub fn settled(&self) -> u64 {
+        self.ok.load(Ordering::Relaxed)
+            + self.updated.load(Ordering::Relaxed)
+            + self.skipped.load(Ordering::Relaxed)
+            + self.errors.load(Ordering::Relaxed)
+            + self.missing.load(Ordering::Relaxed)
+    }
+
+    /// Number of files --check found without a header.
+    pub fn missing_count(&self) -> u64 {
+        self.missing.load(Ordering::Relaxed)
+    }
+
+    /// True if this run changed or failed anything worth reporting.
+    pub fn has_activity(&self) -> bool {
+        self.updated.load(Ordering::Relaxed) > 0
+            || self.errors.load(Ordering::Relaxed) > 0
+            || self.missing.load(Ordering::Relaxed) > 0
+    }
+}
+
+/// Appends one `{"type":"file",...}` record and its newline.
+fn push_json_record(buf: &mut String, outcome: &Outcome, path: &Path, detail: &str) {
+    buf.push_str(r#"{"type":"file","outcome":""#);
+    buf.push_str(outcome.name());
+    buf.push_str(r#"","path":"#);
+    push_json_str(buf, &path.to_string_lossy());
+    if !detail.is_empty() {
+        buf.push_str(r#","detail":"#);
+        push_json_str(buf, detail);
+    }
+    buf.push_str("}\n");
+}
+
+/// Appends `s` as a JSON string literal, escaping what must be escaped.
+fn push_json_str(buf: &mut String, s: &str) {
+    buf.push('"');
+    for c in s.chars() {
+        match c {
+            '"' => buf.push_str("\\\""),
+            '\\' => buf.push_str("\\\\"),
+            '\n' => buf.push_str("\\n"),
+            '\r' => buf.push_str("\\r"),
+            '\t' => buf.push_str("\\t"),
+            c if (c as u32) < 0x20 => {
+                buf.push_str(&format!("\\u{:04x}", c as u32));
+            }
+            c => buf.push(c),
+        }
+    }
+    buf.push('"');
+}
@@ -0,0 +1,226 @@
+//    Copyright 2025 Karesis
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+use std::collections::VecDeque;
+use std::ffi::OsString;
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::{Arc, Condvar, Mutex};
+
+/// A frontier path stored as a shared directory prefix plus a leaf name.
+/// Every child of one directory references the same `Arc`'d parent
+/// instead of repeating the whole ancestor chain, so a deep tree's
+/// queued entries cost one leaf name each rather than one full path
+/// each; the OS path is materialized only at the moment of use.
+#[derive(Clone)]
+pub struct EntryPath {
+    /// shared prefix; `None` for seed targets, whose name is the full path
+    parent: Option<Arc<Path>>,
+    name: OsString,
+}
+
+impl EntryPath {
+    /// A seed target: no shared prefix, the name carries the whole path.
+    pub fn seed(path: PathBuf) -> Self {
+        Self {
+            parent: None,
+            name: path.into_os_string(),
+        }
+    }
+
+    /// A directory child: one leaf name against the interned prefix.
+    pub fn child(parent: &Arc<Path>, name: OsString) -> Self {
+        Self {
+            parent: Some(Arc::clone(parent)),
+            name,
+        }
+    }
+
+    /// The full OS path, built when the entry is actually opened.
+    pub fn materialize(&self) -> PathBuf {
+        match &self.parent {
+            Some(parent) => parent.join(&self.name),
+            None => PathBuf::from(&self.name),
+        }
+    }
+}
+
+/// A traversal entry whose kind was captured from `DirEntry::file_type()`
+/// at discovery (free via d_type on most filesystems), so executing it
+/// never needs another stat to decide dir vs file.
+#[derive(Clone)]
+pub enum Entry {
+    Dir(EntryPath),
+    File(EntryPath),
+}
+
+/// A unit of scheduled work: a batch of entries discovered together.
+/// Batching amortizes the queue lock, the wakeup, and the pending-count
+/// bookkeeping over many files instead of paying them per path.
+pub type Batch = Vec<Entry>;
+
+/// Work-stealing scheduler for traversal tasks (batches of paths).
+///
+/// Each worker owns a deque: it pushes and pops at the back (LIFO, keeps the
+/// walk cache-warm), while idle workers steal from the front of a victim's
+/// deque (FIFO, grabs the oldest — usually largest — subtree). Seed tasks are
+/// dealt round-robin so all workers start busy. Dispatch cost no longer goes
+/// through one global lock, so it stops scaling with thread count.
+pub struct WorkQueue {
+    /// one deque per worker; owner uses the back, thieves the front
+    queues: Vec<Mutex<VecDeque<Batch>>>,
+    /// tasks queued or currently being executed; workers exit when this
+    /// drops to zero, since no one can produce new work anymore
+    pending: AtomicUsize,
+    /// number of workers blocked in `pop`; lets `push` skip the wakeup
+    /// lock entirely on the common (everyone busy) path
+    sleepers: AtomicUsize,
+    sleep_lock: Mutex<()>,
+    cond: Condvar,
+    /// workers with an id at or above this park instead of popping; the
+    /// adaptive controller moves it to grow or shrink the active set
+    active_limit: AtomicUsize,
+    gate_lock: Mutex<()>,
+    gate_cond: Condvar,
+}
+
+impl WorkQueue {
+    pub fn new(workers: usize, seed: Vec<Batch>) -> Self {
+        let mut queues: Vec<Mutex<VecDeque<Batch>>> = Vec::with_capacity(workers);
+        for _ in 0..workers {
+            queues.push(Mutex::new(VecDeque::new()));
+        }
+
+        // deal the seed round-robin so every worker has something to expand
+        let pending = seed.len();
+        for (i, task) in seed.into_iter().enumerate() {
+            queues[i % workers].get_mut().unwrap().push_back(task);
+        }
+
+        Self {
+            queues,
+            pending: AtomicUsize::new(pending),
+            sleepers: AtomicUsize::new(0),
+            sleep_lock: Mutex::new(()),
+            cond: Condvar::new(),
+            active_limit: AtomicUsize::new(workers),
+            gate_lock: Mutex::new(()),
+            gate_cond: Condvar::new(),
+        }
+    }
+
+    /// How many worker slots the queue was built with.
+    pub fn worker_count(&self) -> usize {
+        self.queues.len()
+    }
+
+    /// Moves the active-worker gate: workers below `limit` run, the rest
+    /// park. Raising it wakes parked workers; a parked worker's deque is
+    /// still stealable, so no task is stranded behind the gate.
+    pub fn set_active_limit(&self, limit: usize) {
+        {
+            let _guard = self.gate_lock.lock().unwrap();
+            self.active_limit.store(limit, Ordering::SeqCst);
+            self.gate_cond.notify_all();
+        }
+        // also rescan the sleepers: a worker woken for a task just before
+        // the limit dropped may have parked instead of taking it
+        let _guard = self.sleep_lock.lock().unwrap();
+        self.cond.notify_all();
+    }
+
+    /// Pushes a newly discovered task onto `worker`'s own deque.
+    pub fn push(&self, worker: usize, task: Batch) {
+        self.pending.fetch_add(1, Ordering::SeqCst);
+        self.queues[worker].lock().unwrap().push_back(task);
+
+        // only pay for the wakeup if someone is actually asleep
+        if self.sleepers.load(Ordering::SeqCst) > 0 {
+            let _guard = self.sleep_lock.lock().unwrap();
+            self.cond.notify_one();
+        }
+    }
+
+    /// Pops the next task for `worker`: own deque first, then steal.
+    /// Blocks when everything is empty; returns `None` on global completion.
+    pub fn pop(&self, worker: usize) -> Option<Batch> {
+        loop {
+            // adaptive gate: a worker above the limit parks here, off the
+            // sleeper count, so it cannot swallow a task wakeup meant for
+            // an active worker. It returns when the limit rises or the
+            // run completes.
+            while worker >= self.active_limit.load(Ordering::SeqCst)
+                && self.pending.load(Ordering::SeqCst) != 0
+            {
+                let guard = self.gate_lock.lock().unwrap();
+                if worker < self.active_limit.load(Ordering::SeqCst)
+                    || self.pending.load(Ordering::SeqCst) == 0
+                {
+                    break;
+                }
+                drop(self.gate_cond.wait(guard).unwrap());
+            }
+
+            if let Some(task) = self.try_pop(worker) {
+                return Some(task);
+            }
+
+            let mut guard = self.sleep_lock.lock().unwrap();
+            // register as a sleeper *before* the recheck: a push that missed
+            // our sleeper count will then be caught by this second scan
+            self.sleepers.fetch_add(1, Ordering::SeqCst);
+            if let Some(task) = self.try_pop(worker) {
+                self.sleepers.fetch_sub(1, Ordering::SeqCst);
+                return Some(task);
+            }
+            if self.pending.load(Ordering::SeqCst) == 0 {
+                self.sleepers.fetch_sub(1, Ordering::SeqCst);
+                return None;
+            }
+            guard = self.cond.wait(guard).unwrap();
+            drop(guard);
+            self.sleepers.fetch_sub(1, Ordering::SeqCst);
+        }
+    }
+
+    /// Marks one popped task as done. The last completion wakes everyone
+    /// so blocked workers can observe termination.
+    pub fn complete(&self) {
+        if self.pending.fetch_sub(1, Ordering::SeqCst) == 1 {
+            {
+                let _guard = self.sleep_lock.lock().unwrap();
+                self.cond.notify_all();
+            }
+            // parked workers wait on the gate, not the sleeper condvar
+            let _guard = self.gate_lock.lock().unwrap();
+            self.gate_cond.notify_all();
+        }
+    }
+
+    fn try_pop(&self, worker: usize) -> Option<Batch> {
+        if let Some(task) = self.queues[worker].lock().unwrap().pop_back() {
+            return Some(task);
+        }
+
+        // steal: scan victims starting just after ourselves
+        let n = self.queues.len();
+        for i in 1..n {
+            let victim = (worker + i) % n;
+            if let Some(task) = self.queues[victim].lock().unwrap().pop_front() {
+                return Some(task);
+            }
+        }
+        None
+    }
+}
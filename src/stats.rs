@@ -0,0 +1,162 @@
+//    Copyright 2025 Karesis
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::time::{Duration, Instant};
+
+/// Hot-path phases whose wall time is accumulated per worker.
+#[derive(Clone, Copy)]
+pub enum Phase {
+    /// expanding directories (read_dir + classify)
+    Traverse = 0,
+    /// reading file contents (probe and remainder)
+    Read = 1,
+    /// byte comparison of the head against the rendered header
+    HeaderCheck = 2,
+    /// temp-file write + rename
+    Write = 3,
+    /// blocked in the work queue waiting for tasks
+    Idle = 4,
+}
+
+const PHASE_COUNT: usize = 5;
+const PHASE_NAMES: [&str; PHASE_COUNT] = [
+    "traversal",
+    "file read",
+    "header check",
+    "write",
+    "queue idle",
+];
+
+/// Cheap always-on-when-enabled instrumentation: relaxed atomic counters
+/// bumped on the hot paths, printed as a per-phase breakdown at exit.
+/// When disabled (`--stats` absent) every probe short-circuits before
+/// touching the clock, so the cost is one branch.
+pub struct Stats {
+    enabled: bool,
+    phase_ns: [AtomicU64; PHASE_COUNT],
+    pub dirs_read: AtomicU64,
+    pub paths_discovered: AtomicU64,
+    pub bytes_read: AtomicU64,
+    pub bytes_written: AtomicU64,
+}
+
+impl Stats {
+    pub fn new(enabled: bool) -> Self {
+        Self {
+            enabled,
+            phase_ns: [const { AtomicU64::new(0) }; PHASE_COUNT],
+            dirs_read: AtomicU64::new(0),
+            paths_discovered: AtomicU64::new(0),
+            bytes_read: AtomicU64::new(0),
+            bytes_written: AtomicU64::new(0),
+        }
+    }
+
+    /// Starts a phase timer; `None` when stats are off.
+    pub fn start(&self) -> Option<Instant> {
+        if self.enabled {
+            Some(Instant::now())
+        } else {
+            None
+        }
+    }
+
+    /// Charges the elapsed time since `start` to `phase`.
+    pub fn finish(&self, phase: Phase, start: Option<Instant>) {
+        if let Some(t0) = start {
+            self.phase_ns[phase as usize]
+                .fetch_add(t0.elapsed().as_nanos() as u64, Ordering::Relaxed);
+        }
+    }
+
+    /// Adds to a count; a no-op while disabled so call sites stay branch-free.
+    pub fn count(&self, counter: &AtomicU64, amount: u64) {
+        if self.enabled {
+            counter.fetch_add(amount, Ordering::Relaxed);
+        }
+    }
+
+    /// Prints the per-phase breakdown and worker utilization. With
+    /// `to_stderr` the block goes to stderr -- a json run streams NDJSON
+    /// records on stdout, and the human-readable block must not be
+    /// interleaved with them.
+    pub fn print(&self, wall: Duration, workers: usize, to_stderr: bool) {
+        if !self.enabled {
+            return;
+        }
+
+        use std::fmt::Write as _;
+        let mut block = String::new();
+        let out = &mut block;
+        let _ = writeln!(out, "--- stats ---");
+        let _ = writeln!(
+            out,
+            "wall time        {:>10.3} s  ({} workers)",
+            wall.as_secs_f64(),
+            workers
+        );
+
+        let worker_ns = wall.as_nanos() as u64 * workers as u64;
+        for (name, ns) in PHASE_NAMES.iter().zip(&self.phase_ns) {
+            let ns = ns.load(Ordering::Relaxed);
+            let share = if worker_ns > 0 {
+                ns as f64 * 100.0 / worker_ns as f64
+            } else {
+                0.0
+            };
+            let _ = writeln!(
+                out,
+                "{:<16} {:>10.3} s  ({:.1}% of worker time)",
+                name,
+                ns as f64 / 1e9,
+                share
+            );
+        }
+
+        let idle = self.phase_ns[Phase::Idle as usize].load(Ordering::Relaxed);
+        let busy_pct = if worker_ns > 0 {
+            (worker_ns.saturating_sub(idle)) as f64 * 100.0 / worker_ns as f64
+        } else {
+            0.0
+        };
+        let _ = writeln!(out, "utilization      {:>9.1} %", busy_pct);
+        let _ = writeln!(
+            out,
+            "dirs read        {:>10}",
+            self.dirs_read.load(Ordering::Relaxed)
+        );
+        let _ = writeln!(
+            out,
+            "paths discovered {:>10}",
+            self.paths_discovered.load(Ordering::Relaxed)
+        );
+        let _ = writeln!(
+            out,
+            "bytes read       {:>10}",
+            self.bytes_read.load(Ordering::Relaxed)
+        );
+        let _ = writeln!(
+            out,
+            "bytes written    {:>10}",
+            self.bytes_written.load(Ordering::Relaxed)
+        );
+
+        if to_stderr {
+            eprint!("{}", block);
+        } else {
+            print!("{}", block);
+        }
+    }
+}
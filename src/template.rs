@@ -0,0 +1,128 @@
+//    Copyright 2025 Karesis
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+
+//! Template variables in the license text: `{year}`, `{owner}` and
+//! `{filename}`.
+//!
+//! The text is split into segments once at startup. Run-constant
+//! variables are folded into the static segments right away, so a header
+//! without `{filename}` compiles down to a single string and costs
+//! nothing per file -- exactly what the engine compared before templating
+//! existed. Only headers that use `{filename}` pay a per-file render.
+//! Unrecognized braces pass through untouched.
+
+use std::time::{SystemTime, UNIX_EPOCH};
+
+enum Segment {
+    Text(String),
+    /// the processed file's name, substituted per file
+    Filename,
+}
+
+pub struct Template {
+    segments: Vec<Segment>,
+}
+
+impl Template {
+    /// Splits `raw` into segments, folding `{year}` and `{owner}` in
+    /// place. Errs if `{owner}` is used without a value to fold.
+    pub fn compile(raw: &str, owner: Option<&str>) -> Result<Self, String> {
+        let year = current_year().to_string();
+        let mut segments: Vec<Segment> = Vec::new();
+        let mut text = String::new();
+        let mut rest = raw;
+
+        while let Some(brace) = rest.find('{') {
+            text.push_str(&rest[..brace]);
+            let tail = &rest[brace..];
+            if let Some(after) = tail.strip_prefix("{year}") {
+                text.push_str(&year);
+                rest = after;
+            } else if let Some(after) = tail.strip_prefix("{owner}") {
+                match owner {
+                    Some(owner) => text.push_str(owner),
+                    None => {
+                        return Err(
+                            "license header uses {owner}; pass --owner <NAME> to set it".into()
+                        );
+                    }
+                }
+                rest = after;
+            } else if let Some(after) = tail.strip_prefix("{filename}") {
+                segments.push(Segment::Text(std::mem::take(&mut text)));
+                segments.push(Segment::Filename);
+                rest = after;
+            } else {
+                // not a variable: keep the brace literally
+                text.push('{');
+                rest = &tail[1..];
+            }
+        }
+        text.push_str(rest);
+        segments.push(Segment::Text(text));
+        Ok(Self { segments })
+    }
+
+    /// True when every variable was folded at compile time; `render` then
+    /// returns the same text for every file.
+    pub fn is_static(&self) -> bool {
+        self.segments.len() == 1
+    }
+
+    /// The fully-folded text of a static template.
+    pub fn static_text(&self) -> &str {
+        debug_assert!(self.is_static());
+        match &self.segments[0] {
+            Segment::Text(t) => t,
+            Segment::Filename => "",
+        }
+    }
+
+    /// Substitutes the per-file variables.
+    pub fn render(&self, filename: &str) -> String {
+        let len: usize = self
+            .segments
+            .iter()
+            .map(|s| match s {
+                Segment::Text(t) => t.len(),
+                Segment::Filename => filename.len(),
+            })
+            .sum();
+        let mut out = String::with_capacity(len);
+        for seg in &self.segments {
+            match seg {
+                Segment::Text(t) => out.push_str(t),
+                Segment::Filename => out.push_str(filename),
+            }
+        }
+        out
+    }
+}
+
+/// Current year in UTC, from the epoch clock alone (civil-from-days,
+/// Gregorian) -- enough for a copyright line without a date dependency.
+fn current_year() -> i64 {
+    let secs = SystemTime::now()
+        .duration_since(UNIX_EPOCH)
+        .unwrap_or_default()
+        .as_secs();
+    let z = (secs / 86400) as i64 + 719468;
+    let era = z.div_euclid(146097);
+    let doe = z.rem_euclid(146097);
+    let yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    let y = yoe + era * 400;
+    let doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    let mp = (5 * doy + 2) / 153;
+    if mp >= 10 { y + 1 } else { y }
+}